@@ -3,57 +3,128 @@
 //  Distributed under the Boost Software License, Version 1.0. (See accompanying
 //  file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
 
-#include <hpx/util/bind_action.hpp>
+#ifndef BENCHMARKS_NETWORK_BROADCAST_HPP
+#define BENCHMARKS_NETWORK_BROADCAST_HPP
 
+#include <hpx/hpx.hpp>
+#include <hpx/lcos/local/and_gate.hpp>
+#include <hpx/lcos/local/promise.hpp>
+#include <hpx/lcos/local/spinlock.hpp>
+#include <hpx/util/serialize_buffer.hpp>
+
+#include <boost/foreach.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+// Every broadcast consists of an action which delivers the value to one
+// component and forwards it to the components of its subtree. The value is
+// passed by const reference all the way, a serialize_buffer is only copied
+// as a reference counted handle, the payload itself is copied only when it
+// is sent over the wire.
+//
+// Large values are sent in segments by a second action, every component
+// forwards a segment as soon as it arrived, so the levels of the tree work
+// on different segments at the same time. TYPE has to be a serialize_buffer.
+//
+// A hierarchical broadcast builds the tree over localities instead of
+// components: the value crosses the network once per locality, the
+// components of a locality get it from the first one in shared memory.
 #define HPX_DEFINE_COMPONENT_BROADCAST(NAME, TYPE)                              \
-    void BOOST_PP_CAT(NAME, _)(TYPE const & value)                              \
+    void BOOST_PP_CAT(NAME, _)(std::vector<hpx::id_type> const & subtree,       \
+        TYPE const & value, bool hierarchical)                                  \
     {                                                                           \
-        NAME .set(hpx::util::any(value));                                       \
+        NAME .receive(subtree, value, hierarchical);                            \
     }                                                                           \
     HPX_DEFINE_COMPONENT_ACTION(broadcast_component, BOOST_PP_CAT(NAME, _));    \
                                                                                 \
-    ::hpx::lcos::broadcast<BOOST_PP_CAT(BOOST_PP_CAT(NAME, _), _action)> NAME;  \
+    void BOOST_PP_CAT(NAME, _segment_)(                                         \
+        std::vector<hpx::id_type> const & subtree, std::size_t offset,          \
+        std::size_t size, TYPE const & segment, bool hierarchical)              \
+    {                                                                           \
+        NAME .receive_segment(subtree, offset, size, segment, hierarchical);    \
+    }                                                                           \
+    HPX_DEFINE_COMPONENT_ACTION(broadcast_component,                            \
+        BOOST_PP_CAT(NAME, _segment_));                                         \
+                                                                                \
+    typedef ::hpx::lcos::broadcast<                                             \
+        BOOST_PP_CAT(BOOST_PP_CAT(NAME, _), _action)                            \
+      , BOOST_PP_CAT(BOOST_PP_CAT(NAME, _segment_), _action)                    \
+      , TYPE                                                                    \
+    > BOOST_PP_CAT(NAME, _type);                                                \
+    BOOST_PP_CAT(NAME, _type) NAME;                                             \
 /**/
 
 namespace hpx { namespace lcos
 {
     namespace detail
     {
-        void broadcast_impl(std::vector<hpx::id_type> ids,
-            hpx::util::function<void(hpx::id_type)> fun, std::size_t fan_out = 2);
-        HPX_DEFINE_PLAIN_ACTION(broadcast_impl, broadcast_impl_action);
+        template <typename T>
+        struct buffer_value;
+
+        template <typename T, typename Allocator>
+        struct buffer_value<hpx::util::serialize_buffer<T, Allocator> >
+        {
+            typedef T type;
+        };
     }
 
-    template <typename Action>
+    template <typename Action, typename SegmentAction, typename T>
     struct broadcast
     {
+        enum algorithm
+        {
+            AUTOMATIC           = 0,    // pipelined from segment_threshold on
+            STORE_AND_FORWARD   = 1,
+            PIPELINED           = 2
+        };
+
+        typedef typename detail::buffer_value<T>::type value_type;
+
+        // a component to send the value to, which forwards it to ids
+        struct subtree_type
+        {
+            hpx::id_type target;
+            std::vector<hpx::id_type> ids;
+        };
+
         broadcast()
-          : ready_future(ready_promise.get_future())
+          : fan_out(2)
+          , segment_size(0)
+          , segment_threshold(0)
+          , ready_future(ready_promise.get_future())
           , bcast_future(hpx::lcos::make_ready_future())
+          , segment_data(0)
+          , segment_received(0)
         {}
 
         explicit broadcast(hpx::id_type id, std::size_t fan_out = 2)
           : this_id(id)
+          , fan_out(fan_out)
+          , segment_size(0)
+          , segment_threshold(0)
           , ready_future(ready_promise.get_future())
           , bcast_future(hpx::lcos::make_ready_future())
+          , segment_data(0)
+          , segment_received(0)
         {}
 
-        template <typename A0>
-        A0 when_src(A0 const & a0)
+        T when_dst()
         {
-            return a0;
-        }
-        
-        template <typename A0>
-        A0 when_dst()
-        {
-            return recv_value.cast<A0>();
+            return recv_value;
         }
 
-        template <typename A0>
-        hpx::future<A0> operator()(std::vector<hpx::id_type> const & ids, std::size_t src, A0 const & a0)
+        hpx::future<T> operator()(std::vector<hpx::id_type> const & ids, std::size_t src,
+            T const & value, algorithm alg = AUTOMATIC, bool hierarchical = false)
         {
             hpx::wait_all(bcast_future);
+            if(!forward_futures.empty())
+            {
+                hpx::wait_all(forward_futures);
+                forward_futures.clear();
+            }
+
             if(ids[src] == this_id)
             {
                 std::vector<hpx::id_type> bcast_ids;
@@ -63,21 +134,34 @@ namespace hpx { namespace lcos
                     if(id == this_id) continue;
                     bcast_ids.push_back(id);
                 }
-                
-                if(bcast_ids.size() > 0)
+
+                if(alg == AUTOMATIC)
+                {
+                    alg = segment_threshold != 0 && value.size() >= segment_threshold
+                        ? PIPELINED : STORE_AND_FORWARD;
+                }
+
+                std::vector<subtree_type> subtrees;
+                std::vector<hpx::id_type> local;
+                split(bcast_ids, hierarchical, subtrees, local);
+
+                if(alg == PIPELINED && segment_size != 0 && value.size() > 0)
+                {
+                    value_type * data = const_cast<value_type *>(value.data());
+                    for(std::size_t offset = 0; offset < value.size(); offset += segment_size)
+                    {
+                        std::size_t n = (std::min)(segment_size, value.size() - offset);
+                        send_segment(subtrees, offset, value.size(),
+                            T(data + offset, n, T::reference), hierarchical, forward_futures);
+                    }
+                    send(std::vector<subtree_type>(), local, value, hierarchical, forward_futures);
+                }
+                else
                 {
-                    hpx::id_type locality = hpx::naming::get_locality_from_id(bcast_ids[0]);
-                    Action act;
-
-                    bcast_future =
-                        hpx::async<detail::broadcast_impl_action>(
-                            locality
-                          , std::move(bcast_ids)
-                          , hpx::util::bind(act, hpx::util::placeholders::_1, a0)
-                          , fan_out
-                        );
+                    send(subtrees, local, value, hierarchical, forward_futures);
                 }
-                return hpx::lcos::make_ready_future(a0);
+
+                return hpx::lcos::make_ready_future(value);
             }
             else
             {
@@ -89,85 +173,220 @@ namespace hpx { namespace lcos
                     ready_promise = hpx::lcos::local::promise<void>();
                 }
 
-                return bcast_future.then(HPX_STD_BIND(&broadcast::when_dst<A0>, this));
+                return bcast_future.then(HPX_STD_BIND(&broadcast::when_dst, this));
             }
         }
 
-        void set(hpx::util::any const & v)
+        // Split the ids this component has to forward to into at most
+        // fan_out subtrees. The flat tree uses contiguous ranges of ids. The
+        // hierarchical tree puts the ids on this locality into local and
+        // uses contiguous ranges of the other localities, each subtree
+        // starts at the first component of its first locality.
+        void split(std::vector<hpx::id_type> const & ids, bool hierarchical,
+            std::vector<subtree_type> & subtrees, std::vector<hpx::id_type> & local) const
         {
-            hpx::wait_all(ready_future);
+            typedef std::vector<hpx::id_type>::const_iterator iterator;
+
+            if(!hierarchical)
             {
-                mutex_type::scoped_lock lk(mtx);
-                recv_value = v;
-                bcast_gate.set(0);
-                ready_future = ready_promise.get_future();
+                std::size_t num_subtrees = (std::min)(fan_out, ids.size());
+                subtrees.resize(num_subtrees);
+                for(std::size_t i = 0; i < num_subtrees; ++i)
+                {
+                    iterator begin = ids.begin() + (i * ids.size()) / num_subtrees;
+                    iterator end = ids.begin() + ((i + 1) * ids.size()) / num_subtrees;
+
+                    subtrees[i].target = *begin;
+                    subtrees[i].ids.assign(begin + 1, end);
+                }
+                return;
             }
-        }
-        
-        typedef hpx::lcos::local::spinlock mutex_type;
-        mutex_type mtx;
 
-        hpx::id_type this_id;
-        std::size_t fan_out;
+            hpx::id_type here = hpx::naming::get_locality_from_id(this_id);
 
-        hpx::lcos::local::and_gate bcast_gate;
-        hpx::lcos::local::promise<void> ready_promise;
-        hpx::future<void> ready_future;
-        hpx::util::any recv_value;
-        hpx::future<void> bcast_future;
-    };
+            std::vector<hpx::id_type> localities;
+            std::vector<std::vector<hpx::id_type> > groups;
+            BOOST_FOREACH(hpx::id_type const & id, ids)
+            {
+                hpx::id_type locality = hpx::naming::get_locality_from_id(id);
+                if(locality == here)
+                {
+                    local.push_back(id);
+                    continue;
+                }
 
-    namespace detail
-    {
-        void broadcast_impl(std::vector<hpx::id_type> ids, hpx::util::function<void(hpx::id_type)> fun, std::size_t fan_out)
+                // the ids of a locality are usually contiguous
+                std::size_t group = localities.size();
+                if(!localities.empty() && localities.back() == locality)
+                {
+                    group = localities.size() - 1;
+                }
+                else
+                {
+                    group = std::find(localities.begin(), localities.end(), locality)
+                        - localities.begin();
+                }
+
+                if(group == localities.size())
+                {
+                    localities.push_back(locality);
+                    groups.push_back(std::vector<hpx::id_type>());
+                }
+                groups[group].push_back(id);
+            }
+
+            std::size_t num_subtrees = (std::min)(fan_out, groups.size());
+            subtrees.resize(num_subtrees);
+            for(std::size_t i = 0; i < num_subtrees; ++i)
+            {
+                std::size_t begin = (i * groups.size()) / num_subtrees;
+                std::size_t end = ((i + 1) * groups.size()) / num_subtrees;
+
+                subtrees[i].target = groups[begin][0];
+                subtrees[i].ids.assign(groups[begin].begin() + 1, groups[begin].end());
+                for(std::size_t j = begin + 1; j < end; ++j)
+                {
+                    subtrees[i].ids.insert(subtrees[i].ids.end(),
+                        groups[j].begin(), groups[j].end());
+                }
+            }
+        }
+
+        void send(std::vector<subtree_type> const & subtrees,
+            std::vector<hpx::id_type> const & local, T const & value,
+            bool hierarchical, std::vector<hpx::future<void> > & futures) const
         {
-            // Call some action for the fan_out first ids here ...
-            std::vector<hpx::future<void> > broadcast_futures;
-            broadcast_futures.reserve((std::min)(ids.size(), fan_out));
-            for(std::size_t i = 0; i < (std::min)(fan_out, ids.size()); ++i)
+            futures.reserve(futures.size() + subtrees.size() + local.size());
+            BOOST_FOREACH(subtree_type const & subtree, subtrees)
             {
-                broadcast_futures.push_back(
-                    hpx::async(hpx::util::bind(fun, ids[i]))
+                futures.push_back(
+                    hpx::async<Action>(subtree.target, subtree.ids, value, hierarchical)
                 );
             }
+            BOOST_FOREACH(hpx::id_type const & id, local)
+            {
+                futures.push_back(
+                    hpx::async<Action>(id, std::vector<hpx::id_type>(), value, hierarchical)
+                );
+            }
+        }
 
-            if(ids.size() > fan_out)
+        void send_segment(std::vector<subtree_type> const & subtrees, std::size_t offset,
+            std::size_t size, T const & segment, bool hierarchical,
+            std::vector<hpx::future<void> > & futures) const
+        {
+            futures.reserve(futures.size() + subtrees.size());
+            BOOST_FOREACH(subtree_type const & subtree, subtrees)
             {
-                typedef std::vector<hpx::id_type>::const_iterator iterator;
-                iterator begin = ids.cbegin() + fan_out;
+                futures.push_back(
+                    hpx::async<SegmentAction>(subtree.target, subtree.ids,
+                        offset, size, segment, hierarchical)
+                );
+            }
+        }
 
-                for(std::size_t i = 0; i < fan_out; ++i)
+        // Called by SegmentAction: the segment is forwarded before it is
+        // copied to its place in the value, the value is delivered once all
+        // of its size elements arrived. Segments may arrive in any order.
+        // The components on this locality of a hierarchical broadcast get
+        // the assembled value, not the segments.
+        void receive_segment(std::vector<hpx::id_type> const & ids, std::size_t offset,
+            std::size_t size, T const & segment, bool hierarchical)
+        {
+            std::vector<subtree_type> subtrees;
+            std::vector<hpx::id_type> local;
+            split(ids, hierarchical, subtrees, local);
+
+            std::vector<hpx::future<void> > futures;
+            send_segment(subtrees, offset, size, segment, hierarchical, futures);
+
+            value_type * data = 0;
+            {
+                mutex_type::scoped_lock lk(mtx);
+                if(segment_data == 0)
                 {
-                    std::size_t next_dist = (ids.size() - fan_out)/fan_out + 1;
-                    iterator end
-                        = ((i == fan_out-1) || ((std::distance(ids.cbegin() + fan_out, begin) + next_dist) >= ids.size()))
-                        ? ids.cend()
-                        : begin + next_dist;
-
-                    std::vector<hpx::id_type> next(begin, end);
-                    if(next.size() > 0)
-                    {
-                        hpx::id_type dst = hpx::naming::get_locality_from_id(next[0]);
-
-                        broadcast_futures.push_back(
-                            hpx::async<broadcast_impl_action>(dst, boost::move(next), fun, fan_out)
-                        );
-                        /*
-                        hpx::apply<broadcast_impl_action>(dst, boost::move(next), fun, fan_out);
-                        */
-                    }
+                    segment_data = new value_type[size];
+                }
+                data = segment_data;
+            }
 
-                    if(end == ids.cend()) break;
+            std::memcpy(data + offset, segment.data(), segment.size() * sizeof(value_type));
 
-                    begin = end;
+            bool complete = false;
+            {
+                mutex_type::scoped_lock lk(mtx);
+                segment_received += segment.size();
+                if(segment_received == size)
+                {
+                    complete = true;
+                    segment_data = 0;
+                    segment_received = 0;
                 }
             }
 
+            if(complete)
+            {
+                T value(data, size, T::take);
+                send(std::vector<subtree_type>(), local, value, hierarchical, futures);
+                set(value);
+            }
 
-            if(broadcast_futures.size() > 0)
+            if(!futures.empty())
             {
-                hpx::wait_all(broadcast_futures);
+                hpx::wait_all(futures);
             }
         }
-    }
+
+        // Called by Action: forward to the subtree first, so that the
+        // children get the value as early as possible, then deliver it
+        // locally. Returns once the whole subtree has the value.
+        void receive(std::vector<hpx::id_type> const & ids, T const & value, bool hierarchical)
+        {
+            std::vector<subtree_type> subtrees;
+            std::vector<hpx::id_type> local;
+            split(ids, hierarchical, subtrees, local);
+
+            std::vector<hpx::future<void> > futures;
+            send(subtrees, local, value, hierarchical, futures);
+
+            set(value);
+
+            if(!futures.empty())
+            {
+                hpx::wait_all(futures);
+            }
+        }
+
+        void set(T const & v)
+        {
+            hpx::wait_all(ready_future);
+            {
+                mutex_type::scoped_lock lk(mtx);
+                recv_value = v;
+                bcast_gate.set(0);
+                ready_future = ready_promise.get_future();
+            }
+        }
+
+        typedef hpx::lcos::local::spinlock mutex_type;
+        mutex_type mtx;
+
+        hpx::id_type this_id;
+        std::size_t fan_out;
+        std::size_t segment_size;       // elements per segment of a pipelined broadcast
+        std::size_t segment_threshold;  // smallest value sent pipelined, 0: never
+
+        hpx::lcos::local::and_gate bcast_gate;
+        hpx::lcos::local::promise<void> ready_promise;
+        hpx::future<void> ready_future;
+        T recv_value;
+        hpx::future<void> bcast_future;
+        std::vector<hpx::future<void> > forward_futures;
+
+        // value of a pipelined broadcast being assembled
+        value_type * segment_data;
+        std::size_t segment_received;
+    };
 }}
+
+#endif
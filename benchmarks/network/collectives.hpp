@@ -0,0 +1,660 @@
+//  Copyright (c) 2026 The STE||AR Group
+//
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef BENCHMARKS_NETWORK_COLLECTIVES_HPP
+#define BENCHMARKS_NETWORK_COLLECTIVES_HPP
+
+#include <hpx/hpx.hpp>
+#include <hpx/include/components.hpp>
+#include <hpx/lcos/local/promise.hpp>
+#include <hpx/lcos/local/spinlock.hpp>
+#include <hpx/util/serialize_buffer.hpp>
+
+#include <benchmarks/network/latency_histogram.hpp>
+
+#include <boost/cstdint.hpp>
+#include <boost/foreach.hpp>
+#include <boost/shared_ptr.hpp>
+
+#include <algorithm>
+#include <map>
+#include <vector>
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#endif
+
+///////////////////////////////////////////////////////////////////////////////
+// out = a + b, vectorized with AVX or SSE2 where available
+inline void vector_sum(double * out, double const * a, double const * b, std::size_t n)
+{
+    std::size_t i = 0;
+#if defined(__AVX__)
+    for(; i + 8 <= n; i += 8)
+    {
+        __m256d x0 = _mm256_add_pd(_mm256_loadu_pd(a + i), _mm256_loadu_pd(b + i));
+        __m256d x1 = _mm256_add_pd(_mm256_loadu_pd(a + i + 4), _mm256_loadu_pd(b + i + 4));
+        _mm256_storeu_pd(out + i, x0);
+        _mm256_storeu_pd(out + i + 4, x1);
+    }
+#elif defined(__SSE2__) || defined(_M_X64)
+    for(; i + 4 <= n; i += 4)
+    {
+        __m128d x0 = _mm_add_pd(_mm_loadu_pd(a + i), _mm_loadu_pd(b + i));
+        __m128d x1 = _mm_add_pd(_mm_loadu_pd(a + i + 2), _mm_loadu_pd(b + i + 2));
+        _mm_storeu_pd(out + i, x0);
+        _mm_storeu_pd(out + i + 2, x1);
+    }
+#endif
+    for(; i < n; ++i)
+    {
+        out[i] = a[i] + b[i];
+    }
+}
+
+typedef hpx::util::serialize_buffer<double> vector_type;
+typedef std::vector<vector_type> message_type;
+
+///////////////////////////////////////////////////////////////////////////////
+// Messages between the components of a collective, identified by a tag. The
+// receiver and the sender may come first, the slot is removed once both
+// were there.
+struct mailbox
+{
+    typedef hpx::lcos::local::promise<message_type> promise_type;
+
+    struct slot
+    {
+        slot()
+          : promise(new promise_type)
+          , used(false)
+        {}
+
+        boost::shared_ptr<promise_type> promise;
+        bool used;
+    };
+
+    typedef std::map<boost::uint64_t, slot> slots_type;
+
+    void set(boost::uint64_t tag, message_type const & msg)
+    {
+        boost::shared_ptr<promise_type> p = use(tag);
+        p->set_value(msg);
+    }
+
+    hpx::future<message_type> get(boost::uint64_t tag)
+    {
+        boost::shared_ptr<promise_type> p = use(tag);
+        return p->get_future();
+    }
+
+    boost::shared_ptr<promise_type> use(boost::uint64_t tag)
+    {
+        mutex_type::scoped_lock lk(mtx);
+        slot & s = slots[tag];
+        boost::shared_ptr<promise_type> p = s.promise;
+        if(s.used)
+        {
+            slots.erase(tag);
+        }
+        else
+        {
+            s.used = true;
+        }
+        return p;
+    }
+
+    typedef hpx::lcos::local::spinlock mutex_type;
+    mutex_type mtx;
+    slots_type slots;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// One component per OS thread, laid out by create_components. Every
+// component contributes a vector of doubles with all elements set to its
+// rank + 1. Buffers are never written after they were sent, sums go to newly
+// allocated buffers, so messages between components on the same locality
+// are passed by handle without copies.
+struct collective_component
+  : hpx::components::simple_component_base<collective_component>
+{
+    enum collective_type
+    {
+        REDUCE      = 0,
+        ALLREDUCE   = 1,
+        GATHER      = 2,
+        ALLGATHER   = 3,
+        ALLTOALL    = 4
+    };
+
+    enum algorithm_type
+    {
+        BINOMIAL            = 0,    // binomial tree reduce (and broadcast)
+        RECURSIVE_DOUBLING  = 1,
+        RING                = 2,    // reduce-scatter followed by allgather
+        PAIRWISE            = 3,    // alltoall in size - 1 exchanges
+        BRUCK               = 4,    // alltoall in log2(size) exchanges
+        DISSEMINATION       = 5,    // barrier in log2(size) rounds
+        CENTRAL             = 6     // barrier counting arrivals on rank 0
+    };
+
+    collective_component()
+      : rank(0)
+      , seq(0)
+      , arrived(0)
+    {}
+
+    void init(std::vector<hpx::id_type> const & id, std::size_t r, params const & p)
+    {
+        ids = id;
+        rank = r;
+
+        std::size_t n = (std::max)(p.max_msg_size / sizeof(double), std::size_t(1));
+        data = allocate(n);
+        std::fill(data.data(), data.data() + n, static_cast<double>(rank + 1));
+    }
+
+    HPX_DEFINE_COMPONENT_ACTION(collective_component, init);
+
+    void deliver(boost::uint64_t tag, message_type const & msg)
+    {
+        messages.set(tag, msg);
+    }
+
+    HPX_DEFINE_COMPONENT_ACTION(collective_component, deliver);
+
+    // counts the arrivals at a central barrier, only called on rank 0
+    void arrive(boost::uint64_t t)
+    {
+        {
+            mutex_type::scoped_lock lk(mtx);
+            if(++arrived < ids.size() - 1) return;
+            arrived = 0;
+        }
+        messages.set(t, message_type());
+    }
+
+    HPX_DEFINE_COMPONENT_ACTION(collective_component, arrive);
+
+    // average latency in microseconds of a collective over size bytes per
+    // component, for alltoall size is the block sent to every component
+    double run(int collective, int algorithm, std::size_t size,
+        std::size_t iterations, std::size_t skip)
+    {
+        std::size_t n = (std::max)(size / sizeof(double), std::size_t(1));
+        vector_type value(data.data(), n, vector_type::reference);
+
+        // one distinct block for every component
+        vector_type send;
+        message_type blocks;
+        if(collective == ALLTOALL)
+        {
+            send = allocate(n * ids.size());
+            blocks.reserve(ids.size());
+            for(std::size_t i = 0; i < ids.size(); ++i)
+            {
+                std::fill(send.data() + i * n, send.data() + (i + 1) * n,
+                    static_cast<double>(rank * ids.size() + i));
+                blocks.push_back(vector_type(send.data() + i * n, n, vector_type::reference));
+            }
+        }
+
+        double elapsed = 0.0;
+        for(std::size_t i = 0; i < iterations + skip; ++i)
+        {
+            hpx::util::high_resolution_timer t;
+
+            switch(collective)
+            {
+            case REDUCE:
+                reduce(value);
+                break;
+            case ALLREDUCE:
+                allreduce(value, static_cast<algorithm_type>(algorithm));
+                break;
+            case GATHER:
+                gather(value);
+                break;
+            case ALLGATHER:
+                allgather(value);
+                break;
+            case ALLTOALL:
+                alltoall(blocks, static_cast<algorithm_type>(algorithm));
+                break;
+            }
+            ++seq;
+
+            double t_elapsed = t.elapsed();
+            if(i >= skip)
+            {
+                elapsed += t_elapsed;
+            }
+        }
+
+        return (elapsed * 1e6) / iterations;
+    }
+
+    HPX_DEFINE_COMPONENT_ACTION(collective_component, run);
+
+    // latencies in nanoseconds of the single barriers
+    latency_histogram run_barrier(int algorithm, std::size_t iterations, std::size_t skip)
+    {
+        latency_histogram hist;
+        for(std::size_t i = 0; i < iterations + skip; ++i)
+        {
+            hpx::util::high_resolution_timer t;
+
+            if(algorithm == CENTRAL)
+            {
+                barrier_central();
+            }
+            else
+            {
+                barrier_dissemination();
+            }
+            ++seq;
+
+            double t_elapsed = t.elapsed();
+            if(i >= skip)
+            {
+                hist.record(static_cast<boost::uint64_t>(t_elapsed * 1e9));
+            }
+        }
+        return hist;
+    }
+
+    HPX_DEFINE_COMPONENT_ACTION(collective_component, run_barrier);
+
+    ///////////////////////////////////////////////////////////////////////////
+    static vector_type allocate(std::size_t n)
+    {
+        return vector_type(new double[n], n, vector_type::take);
+    }
+
+    static vector_type sum(vector_type const & a, vector_type const & b)
+    {
+        vector_type res = allocate(a.size());
+        vector_sum(res.data(), a.data(), b.data(), a.size());
+        return res;
+    }
+
+    // messages of one collective call are told apart by their step
+    boost::uint64_t tag(std::size_t step) const
+    {
+        return (boost::uint64_t(seq) << 32) | step;
+    }
+
+    void send(std::size_t dst, std::size_t step, message_type const & msg)
+    {
+        hpx::apply<deliver_action>(ids[dst], tag(step), msg);
+    }
+
+    void send(std::size_t dst, std::size_t step, vector_type const & v)
+    {
+        send(dst, step, message_type(1, v));
+    }
+
+    message_type receive(std::size_t step)
+    {
+        return messages.get(tag(step)).get();
+    }
+
+    ///////////////////////////////////////////////////////////////////////////
+    // binomial tree towards rank 0, returns the sum on rank 0
+    vector_type reduce(vector_type acc)
+    {
+        std::size_t size = ids.size();
+        std::size_t step = 0;
+        for(std::size_t mask = 1; mask < size; mask <<= 1, ++step)
+        {
+            if(rank & mask)
+            {
+                send(rank - mask, step, acc);
+                break;
+            }
+            if(rank + mask < size)
+            {
+                acc = sum(acc, receive(step)[0]);
+            }
+        }
+        return acc;
+    }
+
+    // binomial tree from rank 0, steps are numbered from 64 on
+    vector_type broadcast(vector_type value)
+    {
+        std::size_t size = ids.size();
+        std::size_t mask = 1;
+        std::size_t step = 64;
+        for(; mask < size; mask <<= 1, ++step)
+        {
+            if(rank & mask)
+            {
+                value = receive(step)[0];
+                break;
+            }
+        }
+        for(mask >>= 1, --step; mask > 0; mask >>= 1, --step)
+        {
+            if(rank + mask < size)
+            {
+                send(rank + mask, step, value);
+            }
+        }
+        return value;
+    }
+
+    void allreduce(vector_type const & value, algorithm_type algorithm)
+    {
+        switch(algorithm)
+        {
+        case RECURSIVE_DOUBLING:
+            allreduce_recursive_doubling(value);
+            break;
+        case RING:
+            allreduce_ring(value);
+            break;
+        default:
+            broadcast(reduce(value));
+            break;
+        }
+    }
+
+    // Pairwise exchanges with partners at distance 1, 2, 4, ... With a
+    // size that is not a power of two, the ranks above the largest power of
+    // two hand their value to a partner first and get the result back.
+    vector_type allreduce_recursive_doubling(vector_type acc)
+    {
+        std::size_t size = ids.size();
+        std::size_t p2 = 1;
+        while(p2 * 2 <= size) p2 *= 2;
+        std::size_t rem = size - p2;
+
+        if(rank >= p2)
+        {
+            send(rank - p2, 0, acc);
+            return receive(1)[0];
+        }
+        if(rank < rem)
+        {
+            acc = sum(acc, receive(0)[0]);
+        }
+
+        std::size_t step = 2;
+        for(std::size_t mask = 1; mask < p2; mask <<= 1, ++step)
+        {
+            send(rank ^ mask, step, acc);
+            acc = sum(acc, receive(step)[0]);
+        }
+
+        if(rank < rem)
+        {
+            send(rank + p2, 1, acc);
+        }
+        return acc;
+    }
+
+    // Reduce-scatter and allgather around the ring of components, every
+    // step moves one of size chunks to the right neighbour. Bandwidth
+    // optimal for long vectors. The result is left in chunks.
+    message_type allreduce_ring(vector_type const & value)
+    {
+        std::size_t size = ids.size();
+        std::size_t n = value.size();
+        std::size_t right = (rank + 1) % size;
+
+        message_type chunks;
+        chunks.reserve(size);
+        double * data = const_cast<double *>(value.data());
+        for(std::size_t i = 0; i < size; ++i)
+        {
+            std::size_t begin = (i * n) / size;
+            std::size_t end = ((i + 1) * n) / size;
+            chunks.push_back(vector_type(data + begin, end - begin, vector_type::reference));
+        }
+
+        for(std::size_t k = 0; k + 1 < size; ++k)
+        {
+            send(right, k, chunks[(rank + size - k) % size]);
+            std::size_t i = (rank + 2 * size - k - 1) % size;
+            chunks[i] = sum(chunks[i], receive(k)[0]);
+        }
+
+        for(std::size_t k = 0; k + 1 < size; ++k)
+        {
+            send(right, size + k, chunks[(rank + size - k + 1) % size]);
+            chunks[(rank + size - k) % size] = receive(size + k)[0];
+        }
+
+        return chunks;
+    }
+
+    // binomial tree towards rank 0, the blocks are passed on by handle,
+    // rank 0 ends up with the blocks of all ranks in rank order
+    message_type gather(vector_type const & value)
+    {
+        std::size_t size = ids.size();
+        message_type blocks(1, value);
+        std::size_t step = 0;
+        for(std::size_t mask = 1; mask < size; mask <<= 1, ++step)
+        {
+            if(rank & mask)
+            {
+                send(rank - mask, step, blocks);
+                break;
+            }
+            if(rank + mask < size)
+            {
+                message_type recv = receive(step);
+                blocks.insert(blocks.end(), recv.begin(), recv.end());
+            }
+        }
+        return blocks;
+    }
+
+    // every step passes the block received last to the right neighbour
+    message_type allgather(vector_type const & value)
+    {
+        std::size_t size = ids.size();
+        std::size_t right = (rank + 1) % size;
+
+        message_type blocks(size);
+        blocks[rank] = value;
+        for(std::size_t k = 0; k + 1 < size; ++k)
+        {
+            send(right, k, blocks[(rank + size - k) % size]);
+            blocks[(rank + 2 * size - k - 1) % size] = receive(k)[0];
+        }
+        return blocks;
+    }
+
+    // blocks[i] is sent to component i, the result holds the block received
+    // from component i at position i
+    message_type alltoall(message_type const & blocks, algorithm_type algorithm)
+    {
+        if(algorithm == BRUCK)
+        {
+            return alltoall_bruck(blocks);
+        }
+        return alltoall_pairwise(blocks);
+    }
+
+    // in step k every component sends to rank + k and receives from
+    // rank - k, one exchange in flight per component
+    message_type alltoall_pairwise(message_type const & blocks)
+    {
+        std::size_t size = ids.size();
+
+        message_type result(size);
+        result[rank] = blocks[rank];
+        for(std::size_t k = 1; k < size; ++k)
+        {
+            std::size_t dst = (rank + k) % size;
+            send(dst, k, blocks[dst]);
+            result[(rank + size - k) % size] = receive(k)[0];
+        }
+        return result;
+    }
+
+    // After rotating the blocks by rank, the block at position i has to
+    // travel i components to the right. Step k forwards all blocks whose
+    // position has bit k set by 2^k components, so every block arrives
+    // after log2(size) steps, at the price of sending size / 2 blocks per
+    // step. Blocks are forwarded by handle and only packed when sent to
+    // another locality.
+    message_type alltoall_bruck(message_type const & blocks)
+    {
+        std::size_t size = ids.size();
+
+        message_type tmp(size);
+        for(std::size_t i = 0; i < size; ++i)
+        {
+            tmp[i] = blocks[(rank + i) % size];
+        }
+
+        std::size_t step = 0;
+        for(std::size_t pof2 = 1; pof2 < size; pof2 <<= 1, ++step)
+        {
+            message_type msg;
+            msg.reserve(size / 2 + 1);
+            for(std::size_t i = 0; i < size; ++i)
+            {
+                if(i & pof2) msg.push_back(tmp[i]);
+            }
+            send((rank + pof2) % size, step, msg);
+
+            message_type recv = receive(step);
+            std::size_t j = 0;
+            for(std::size_t i = 0; i < size; ++i)
+            {
+                if(i & pof2) tmp[i] = recv[j++];
+            }
+        }
+
+        message_type result(size);
+        for(std::size_t i = 0; i < size; ++i)
+        {
+            result[(rank + size - i) % size] = tmp[i];
+        }
+        return result;
+    }
+
+    // In round k every component signals rank + 2^k and waits for the
+    // signal of rank - 2^k. After ceil(log2(size)) rounds every component
+    // has transitively heard from all others, without any of them being a
+    // hot spot.
+    void barrier_dissemination()
+    {
+        std::size_t size = ids.size();
+        std::size_t step = 0;
+        for(std::size_t distance = 1; distance < size; distance <<= 1, ++step)
+        {
+            send((rank + distance) % size, step, message_type());
+            receive(step);
+        }
+    }
+
+    // All components increment a counter on rank 0, which releases them one
+    // by one once the last one arrived.
+    void barrier_central()
+    {
+        std::size_t size = ids.size();
+        if(rank != 0)
+        {
+            hpx::apply<arrive_action>(ids[0], tag(0));
+            receive(0);
+            return;
+        }
+
+        if(size > 1)
+        {
+            receive(0);
+        }
+        for(std::size_t i = 1; i < size; ++i)
+        {
+            send(i, 0, message_type());
+        }
+    }
+
+    typedef hpx::lcos::local::spinlock mutex_type;
+
+    std::vector<hpx::id_type> ids;
+    std::size_t rank;
+    std::size_t seq;            // number of collectives called so far
+    vector_type data;
+    mailbox messages;
+
+    mutex_type mtx;
+    std::size_t arrived;        // components waiting at the central barrier
+};
+
+///////////////////////////////////////////////////////////////////////////////
+inline std::vector<hpx::id_type> init_collective_components(params const & p)
+{
+    std::vector<hpx::id_type> ids = create_components<collective_component>(p);
+
+    std::vector<hpx::future<void> > init_futures;
+    init_futures.reserve(ids.size());
+    for(std::size_t rank = 0; rank < ids.size(); ++rank)
+    {
+        init_futures.push_back(
+            hpx::async<collective_component::init_action>(ids[rank], ids, rank, p)
+        );
+    }
+    hpx::wait_all(init_futures);
+
+    return ids;
+}
+
+// average latency in microseconds over all components
+inline double run_collective(std::vector<hpx::id_type> const & ids, int collective,
+    int algorithm, std::size_t size, std::size_t iterations, std::size_t skip)
+{
+    std::vector<hpx::future<double> > run_futures;
+    run_futures.reserve(ids.size());
+    BOOST_FOREACH(hpx::id_type const & id, ids)
+    {
+        run_futures.push_back(
+            hpx::async<collective_component::run_action>(
+                id, collective, algorithm, size, iterations, skip)
+        );
+    }
+    hpx::wait_all(run_futures);
+
+    double latency = 0.0;
+    BOOST_FOREACH(hpx::future<double> & f, run_futures)
+    {
+        latency += f.get();
+    }
+    return latency / ids.size();
+}
+
+
+// latencies of all barriers of all components
+inline latency_histogram run_barrier(std::vector<hpx::id_type> const & ids,
+    int algorithm, std::size_t iterations, std::size_t skip)
+{
+    std::vector<hpx::future<latency_histogram> > run_futures;
+    run_futures.reserve(ids.size());
+    BOOST_FOREACH(hpx::id_type const & id, ids)
+    {
+        run_futures.push_back(
+            hpx::async<collective_component::run_barrier_action>(
+                id, algorithm, iterations, skip)
+        );
+    }
+    hpx::wait_all(run_futures);
+
+    latency_histogram hist;
+    BOOST_FOREACH(hpx::future<latency_histogram> & f, run_futures)
+    {
+        hist += f.get();
+    }
+    return hist;
+}
+
+#endif
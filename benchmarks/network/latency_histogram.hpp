@@ -0,0 +1,185 @@
+//  Copyright (c) 2026 The STE||AR Group
+//
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef BENCHMARKS_NETWORK_LATENCY_HISTOGRAM_HPP
+#define BENCHMARKS_NETWORK_LATENCY_HISTOGRAM_HPP
+
+#include <hpx/include/iostreams.hpp>
+#include <hpx/include/lcos.hpp>
+#include <hpx/util/high_resolution_clock.hpp>
+
+#include <boost/cstdint.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <vector>
+
+///////////////////////////////////////////////////////////////////////////////
+// Log-linear histogram of latencies in nanoseconds. Values below
+// 2^sub_bucket_bits are counted exactly, above that every power of two is
+// split into 2^sub_bucket_bits equally wide buckets, so a percentile is off
+// by at most 1/2^sub_bucket_bits (3%). Recording a value is a handful of
+// shifts and one increment, histograms of different localities are merged
+// by adding the counts.
+struct latency_histogram
+{
+    static const unsigned sub_bucket_bits = 5;
+    static const std::size_t sub_buckets = std::size_t(1) << sub_bucket_bits;
+    static const std::size_t num_buckets = (64 - sub_bucket_bits + 1) * sub_buckets;
+
+    latency_histogram()
+      : counts(num_buckets, 0)
+      , count(0)
+      , sum(0)
+      , min_value(0)
+      , max_value(0)
+    {}
+
+    static unsigned floor_log2(boost::uint64_t v)
+    {
+        unsigned res = 0;
+        if (v >= (boost::uint64_t(1) << 32)) { v >>= 32; res += 32; }
+        if (v >= (boost::uint64_t(1) << 16)) { v >>= 16; res += 16; }
+        if (v >= (boost::uint64_t(1) << 8))  { v >>= 8;  res += 8; }
+        if (v >= (boost::uint64_t(1) << 4))  { v >>= 4;  res += 4; }
+        if (v >= (boost::uint64_t(1) << 2))  { v >>= 2;  res += 2; }
+        if (v >= (boost::uint64_t(1) << 1))  { res += 1; }
+        return res;
+    }
+
+    static std::size_t bucket(boost::uint64_t v)
+    {
+        if (v < sub_buckets)
+            return static_cast<std::size_t>(v);
+
+        unsigned shift = floor_log2(v) - sub_bucket_bits;
+        return ((shift + 1) << sub_bucket_bits)
+            + static_cast<std::size_t>((v >> shift) - sub_buckets);
+    }
+
+    // smallest value counted in bucket i
+    static boost::uint64_t bucket_begin(std::size_t i)
+    {
+        if (i < sub_buckets)
+            return i;
+
+        unsigned shift = static_cast<unsigned>(i >> sub_bucket_bits) - 1;
+        return boost::uint64_t((i & (sub_buckets - 1)) + sub_buckets) << shift;
+    }
+
+    static boost::uint64_t bucket_width(std::size_t i)
+    {
+        if (i < sub_buckets)
+            return 1;
+        return boost::uint64_t(1) << ((i >> sub_bucket_bits) - 1);
+    }
+
+    void record(boost::uint64_t ns)
+    {
+        ++counts[bucket(ns)];
+        if (count == 0 || ns < min_value) min_value = ns;
+        if (ns > max_value) max_value = ns;
+        ++count;
+        sum += ns;
+    }
+
+    latency_histogram & operator+=(latency_histogram const & rhs)
+    {
+        if (rhs.count == 0)
+            return *this;
+
+        for (std::size_t i = 0; i != num_buckets; ++i)
+            counts[i] += rhs.counts[i];
+
+        min_value = count == 0 ? rhs.min_value : (std::min)(min_value, rhs.min_value);
+        max_value = (std::max)(max_value, rhs.max_value);
+        count += rhs.count;
+        sum += rhs.sum;
+        return *this;
+    }
+
+    double mean() const
+    {
+        return count == 0 ? 0.0 : static_cast<double>(sum) / count;
+    }
+
+    // value below which a fraction q of the recorded values lies, the
+    // midpoint of the bucket the percentile falls into
+    double percentile(double q) const
+    {
+        if (count == 0)
+            return 0.0;
+
+        boost::uint64_t rank =
+            static_cast<boost::uint64_t>(std::ceil(q * static_cast<double>(count)));
+        if (rank == 0) rank = 1;
+        if (rank > count) rank = count;
+
+        boost::uint64_t seen = 0;
+        for (std::size_t i = 0; i != num_buckets; ++i)
+        {
+            seen += counts[i];
+            if (seen >= rank)
+            {
+                double value = bucket_begin(i) + (bucket_width(i) - 1) / 2.0;
+                value = (std::max)(value, static_cast<double>(min_value));
+                return (std::min)(value, static_cast<double>(max_value));
+            }
+        }
+        return static_cast<double>(max_value);
+    }
+
+    template <typename Archive>
+    void serialize(Archive & ar, unsigned)
+    {
+        ar & counts;
+        ar & count;
+        ar & sum;
+        ar & min_value;
+        ar & max_value;
+    }
+
+    std::vector<boost::uint64_t> counts;
+    boost::uint64_t count;
+    boost::uint64_t sum;
+    boost::uint64_t min_value;
+    boost::uint64_t max_value;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// Continuation attached to every message of a window, returns the time its
+// reply arrived. Subtracting the time the message was sent times each message
+// on its own instead of averaging over the window.
+template <typename T>
+boost::uint64_t reply_time(hpx::future<T> f)
+{
+    f.get();
+    return hpx::util::high_resolution_clock::now();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+inline void print_latency_header()
+{
+    hpx::cout << "# Size    Latency   Min       P50       P90       P99       P99.9     Max\n"
+              << "#         (microsec, Latency is the mean over all windows, the percentiles\n"
+              << "#          are of the one way latency of each message, half its round trip)\n"
+              << hpx::flush;
+}
+
+inline void print_latency(std::size_t size, double latency, latency_histogram const & hist)
+{
+    hpx::cout << std::left << std::setw(10) << size
+              << std::setw(10) << latency
+              << std::setw(10) << hist.min_value / 1e3
+              << std::setw(10) << hist.percentile(0.5) / 1e3
+              << std::setw(10) << hist.percentile(0.9) / 1e3
+              << std::setw(10) << hist.percentile(0.99) / 1e3
+              << std::setw(10) << hist.percentile(0.999) / 1e3
+              << hist.max_value / 1e3
+              << hpx::endl << hpx::flush;
+}
+
+#endif
@@ -0,0 +1,75 @@
+//  Copyright (c) 2026 The STE||AR Group
+//
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+// Allreduce network test
+
+#include <hpx/hpx_init.hpp>
+#include <hpx/hpx.hpp>
+#include <hpx/include/iostreams.hpp>
+#include <hpx/include/components.hpp>
+#include <hpx/util/serialize_buffer.hpp>
+
+#include <benchmarks/network/osu_coll.hpp>
+#include <benchmarks/network/collectives.hpp>
+
+HPX_REGISTER_MINIMAL_COMPONENT_FACTORY(
+    hpx::components::simple_component<collective_component>
+  , osu_collective_component);
+
+void run_benchmark(params const & p)
+{
+    std::size_t skip = SKIP;
+    std::size_t iterations = p.iterations;
+
+    std::vector<hpx::id_type> ids = init_collective_components(p);
+
+    if(ids.size() < 2)
+    {
+        hpx::cout << "This benchmark must be run with at least 2 threads" << hpx::endl << hpx::flush;
+        return;
+    }
+
+    for(std::size_t size = sizeof(double); size <= p.max_msg_size; size *=2)
+    {
+        if(size > LARGE_MESSAGE_SIZE)
+        {
+            skip = SKIP_LARGE;
+            iterations = ITERATIONS_LARGE;
+        }
+
+        hpx::cout << std::left << std::setw(10) << size;
+        for(int algorithm = collective_component::BINOMIAL;
+            algorithm <= collective_component::RING; ++algorithm)
+        {
+            hpx::cout << std::setw(20)
+                      << run_collective(ids, collective_component::ALLREDUCE,
+                             algorithm, size, iterations, skip);
+        }
+        hpx::cout << hpx::endl << hpx::flush;
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+int hpx_main(boost::program_options::variables_map & vm)
+{
+    params p(process_args(vm));
+    hpx::cout << "# OSU HPX Allreduce Latency Test" << hpx::endl
+              << "# Size    " << std::left
+                 << std::setw(20) << "Binomial tree"
+                 << std::setw(20) << "Recursive doubling"
+                 << "Ring" << hpx::endl
+              << "#         (latency in microsec, sum of vectors of doubles)" << hpx::endl
+              << hpx::flush;
+    run_benchmark(p);
+    return hpx::finalize();
+}
+
+int main(int argc, char* argv[])
+{
+    boost::program_options::options_description
+        desc(params_desc());
+
+    return hpx::init(desc, argc, argv);
+}
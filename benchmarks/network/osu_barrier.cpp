@@ -0,0 +1,74 @@
+//  Copyright (c) 2026 The STE||AR Group
+//
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+// Barrier network test
+
+#include <hpx/hpx_init.hpp>
+#include <hpx/hpx.hpp>
+#include <hpx/include/iostreams.hpp>
+#include <hpx/include/components.hpp>
+#include <hpx/util/serialize_buffer.hpp>
+
+#include <benchmarks/network/osu_coll.hpp>
+#include <benchmarks/network/collectives.hpp>
+
+HPX_REGISTER_MINIMAL_COMPONENT_FACTORY(
+    hpx::components::simple_component<collective_component>
+  , osu_collective_component);
+
+void print_barrier(std::string const & algorithm, latency_histogram const & hist)
+{
+    hpx::cout << std::left << std::setw(16) << algorithm
+              << std::setw(10) << hist.mean() / 1e3
+              << std::setw(10) << hist.min_value / 1e3
+              << std::setw(10) << hist.percentile(0.5) / 1e3
+              << std::setw(10) << hist.percentile(0.9) / 1e3
+              << std::setw(10) << hist.percentile(0.99) / 1e3
+              << std::setw(10) << hist.percentile(0.999) / 1e3
+              << hist.max_value / 1e3
+              << hpx::endl << hpx::flush;
+}
+
+void run_benchmark(params const & p)
+{
+    std::vector<hpx::id_type> ids = init_collective_components(p);
+
+    if(ids.size() < 2)
+    {
+        hpx::cout << "This benchmark must be run with at least 2 threads" << hpx::endl << hpx::flush;
+        return;
+    }
+
+    hpx::cout << "# " << hpx::find_all_localities().size() << " localities, "
+              << hpx::get_os_thread_count() << " threads per locality, "
+              << ids.size() << " components" << hpx::endl
+              << "# Barrier         Latency   Min       P50       P90       P99       P99.9     Max"
+                 << hpx::endl
+              << "#                 (microsec, mean and percentiles of the latency of every"
+                 << " component)" << hpx::endl
+              << hpx::flush;
+
+    print_barrier("Dissemination",
+        run_barrier(ids, collective_component::DISSEMINATION, p.iterations, SKIP));
+    print_barrier("Central",
+        run_barrier(ids, collective_component::CENTRAL, p.iterations, SKIP));
+}
+
+///////////////////////////////////////////////////////////////////////////////
+int hpx_main(boost::program_options::variables_map & vm)
+{
+    params p(process_args(vm));
+    hpx::cout << "# OSU HPX Barrier Latency Test" << hpx::endl << hpx::flush;
+    run_benchmark(p);
+    return hpx::finalize();
+}
+
+int main(int argc, char* argv[])
+{
+    boost::program_options::options_description
+        desc(params_desc());
+
+    return hpx::init(desc, argc, argv);
+}
@@ -11,43 +11,45 @@
 #include <hpx/include/components.hpp>
 #include <hpx/lcos/local/and_gate.hpp>
 #include <hpx/util/serialize_buffer.hpp>
-#include <hpx/util/any.hpp>
 
 #include <boost/assert.hpp>
 #include <boost/shared_ptr.hpp>
 
+#include <numeric>
+
 #include <benchmarks/network/osu_coll.hpp>
 #include <benchmarks/network/broadcast.hpp>
 
-HPX_REGISTER_PLAIN_ACTION(hpx::lcos::detail::broadcast_impl_action, broadcast_impl_action);
-
-
 struct broadcast_component
   : hpx::components::simple_component_base<broadcast_component>
 {
     broadcast_component()
     {}
 
-    void init(std::vector<hpx::id_type> const & id, std::size_t max_msg_size, std::size_t fan_out)
+    void init(std::vector<hpx::id_type> const & id, params const & p)
     {
         bcast.this_id = this->get_gid();
-        bcast.fan_out = fan_out;
+        bcast.fan_out = p.fan_out;
+        bcast.segment_size = p.segment_size;
+        bcast.segment_threshold = p.segment_threshold;
         ids = id;
-        send_buffer = std::vector<char>(max_msg_size);
+        send_buffer = std::vector<char>(p.max_msg_size);
     }
 
     HPX_DEFINE_COMPONENT_ACTION(broadcast_component, init);
 
     typedef hpx::util::serialize_buffer<char> buffer_type;
 
-    double run(std::size_t size, std::size_t iterations, std::size_t skip)
+    double run(std::size_t size, std::size_t iterations, std::size_t skip,
+        int algorithm, bool hierarchical)
     {
         double elapsed = 0.0;
         for(std::size_t i = 0; i < iterations + skip; ++i)
         {
             hpx::util::high_resolution_timer t;
 
-            recv_buffer = bcast(ids, 0, buffer_type(&send_buffer[0], size, buffer_type::reference)).get();
+            recv_buffer = bcast(ids, 0, buffer_type(&send_buffer[0], size, buffer_type::reference),
+                static_cast<bcast_type::algorithm>(algorithm), hierarchical).get();
 
             double t_elapsed = t.elapsed();
             if(i >= skip)
@@ -74,6 +76,30 @@ HPX_REGISTER_MINIMAL_COMPONENT_FACTORY(
   , osu_broadcast_component);
 
 
+// average latency of a broadcast over all components
+double run(std::vector<hpx::id_type> const & ids, std::size_t size,
+    std::size_t iterations, std::size_t skip, int algorithm, bool hierarchical)
+{
+    std::vector<hpx::future<double> > run_futures;
+    run_futures.reserve(ids.size());
+    BOOST_FOREACH(hpx::id_type const & id, ids)
+    {
+        run_futures.push_back(
+            hpx::async<broadcast_component::run_action>(
+                id, size, iterations, skip, algorithm, hierarchical)
+        );
+    }
+
+    std::vector<double> times; times.reserve(ids.size());
+    hpx::wait_all(run_futures);
+    BOOST_FOREACH(hpx::future<double> & f, run_futures)
+    {
+        times.push_back(f.get());
+    }
+
+    return std::accumulate(times.begin(), times.end(), 0.0) / ids.size();
+}
+
 void run_benchmark(params const & p)
 {
     std::size_t skip = SKIP;
@@ -93,7 +119,7 @@ void run_benchmark(params const & p)
         BOOST_FOREACH(hpx::id_type const & id, ids)
         {
             init_futures.push_back(
-                hpx::async<broadcast_component::init_action>(id, ids, p.max_msg_size, p.fan_out)
+                hpx::async<broadcast_component::init_action>(id, ids, p)
             );
         }
         hpx::wait_all(init_futures);
@@ -107,26 +133,23 @@ void run_benchmark(params const & p)
             iterations = ITERATIONS_LARGE;
         }
 
-        std::vector<hpx::future<double> > run_futures;
-        run_futures.reserve(ids.size());
-        BOOST_FOREACH(hpx::id_type const & id, ids)
+        hpx::cout << std::left << std::setw(10) << size;
+        for(int hierarchical = 0; hierarchical <= (p.hierarchical ? 1 : 0); ++hierarchical)
         {
-            run_futures.push_back(
-                hpx::async<broadcast_component::run_action>(id, size, iterations, skip)
-            );
-        }
-
+            double store_and_forward = run(ids, size, iterations, skip,
+                broadcast_component::bcast_type::STORE_AND_FORWARD, hierarchical != 0);
+            double pipelined = run(ids, size, iterations, skip,
+                broadcast_component::bcast_type::PIPELINED, hierarchical != 0);
 
-        std::vector<double> times; times.reserve(ids.size());
-        hpx::wait_all(run_futures);
-        BOOST_FOREACH(hpx::future<double> & f, run_futures)
-        {
-            times.push_back(f.get());
+            hpx::cout << std::setw(20) << store_and_forward
+                      << std::setw(20) << pipelined;
         }
 
-        double avg_latency = std::accumulate(times.begin(), times.end(), 0.0) / ids.size();
+        // the flat tree with the algorithm picked by segment_threshold
+        double automatic = run(ids, size, iterations, skip,
+            broadcast_component::bcast_type::AUTOMATIC, false);
 
-        print_data(avg_latency, size, iterations);
+        hpx::cout << automatic << hpx::endl << hpx::flush;
     }
 }
 
@@ -134,7 +157,23 @@ void run_benchmark(params const & p)
 int hpx_main(boost::program_options::variables_map & vm)
 {
     params p(process_args(vm));
-    print_header("OSU HPX Broadcast Latency Test");
+    hpx::cout << "# OSU HPX Broadcast Latency Test" << hpx::endl
+              << "# Segment size " << p.segment_size << " bytes, "
+                 << "pipelined from " << p.segment_threshold << " bytes on" << hpx::endl
+              << "# Size    " << std::left
+                 << std::setw(20) << "Store-and-forward" << std::setw(20) << "Pipelined";
+    if(p.hierarchical)
+    {
+        hpx::cout << std::setw(20) << "2-level s-and-f" << std::setw(20) << "2-level pipelined";
+    }
+    hpx::cout << "Automatic" << hpx::endl
+              << "#         (latency in microsec, Automatic: flat tree";
+    if(p.hierarchical)
+    {
+        hpx::cout << ", 2-level: tree across localities, then within each locality";
+    }
+    hpx::cout << ")" << hpx::endl
+              << hpx::flush;
     run_benchmark(p);
     return hpx::finalize();
 }
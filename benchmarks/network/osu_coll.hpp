@@ -13,6 +13,9 @@ struct params
     std::size_t max_msg_size;
     std::size_t iterations;
     std::size_t fan_out;
+    std::size_t segment_size;
+    std::size_t segment_threshold;
+    bool hierarchical;
 
     template <typename Archive>
     void serialize(Archive & ar, unsigned)
@@ -20,6 +23,9 @@ struct params
         ar & max_msg_size;
         ar & iterations;
         ar & fan_out;
+        ar & segment_size;
+        ar & segment_threshold;
+        ar & hierarchical;
     }
 };
 
@@ -37,7 +43,16 @@ boost::program_options::options_description params_desc()
          "Set number of iterations per message size.")
         ("fan-out",
          boost::program_options::value<std::size_t>()->default_value(2),
-         "Set number of iterations per message size.")
+         "Set number of subtrees every node of a collective tree sends to.")
+        ("segment-size",
+         boost::program_options::value<std::size_t>()->default_value(65536),
+         "Set segment size in bytes of pipelined collectives.")
+        ("segment-threshold",
+         boost::program_options::value<std::size_t>()->default_value(262144),
+         "Set message size in bytes from which collectives are pipelined (0: never).")
+        ("hierarchical",
+         "Also measure collectives over a two-level tree: across localities first, "
+         "then within each locality.")
         ;
 
     return desc;
@@ -50,6 +65,9 @@ params process_args(boost::program_options::variables_map & vm)
             vm["max-msg-size"].as<std::size_t>()
           , vm["iter"].as<std::size_t>()
           , vm["fan-out"].as<std::size_t>()
+          , vm["segment-size"].as<std::size_t>()
+          , vm["segment-threshold"].as<std::size_t>()
+          , vm.count("hierarchical") > 0
         }; 
 
     return p;
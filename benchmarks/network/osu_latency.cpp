@@ -9,8 +9,11 @@
 #include <hpx/hpx_init.hpp>
 #include <hpx/hpx.hpp>
 #include <hpx/include/iostreams.hpp>
+#include <hpx/util/high_resolution_clock.hpp>
 #include <hpx/util/serialize_buffer.hpp>
 
+#include <benchmarks/network/latency_histogram.hpp>
+
 #include <boost/assert.hpp>
 #include <boost/shared_ptr.hpp>
 
@@ -56,7 +59,8 @@ double receive(
     char * send_buffer,
     std::size_t size,
     std::size_t loop,
-    std::size_t window_size)
+    std::size_t window_size,
+    latency_histogram & hist)
 {
     int skip = SKIP_LARGE;
 
@@ -65,8 +69,10 @@ double receive(
 
     hpx::util::high_resolution_timer t;
 
-    std::vector<hpx::future<buffer_type> > recv_buffers;
-    recv_buffers.reserve(window_size);
+    std::vector<hpx::future<boost::uint64_t> > replies;
+    std::vector<boost::uint64_t> sent;
+    replies.reserve(window_size);
+    sent.reserve(window_size);
 
     message_action msg;
     for (int i = 0; i != loop + skip; ++i) {
@@ -76,11 +82,21 @@ double receive(
 
         for(std::size_t j = 0; j < window_size; ++j)
         {
-            recv_buffers.push_back(hpx::async(msg, dest, buffer_type(send_buffer, size,
-                buffer_type::reference)));
+            sent.push_back(hpx::util::high_resolution_clock::now());
+            replies.push_back(hpx::async(msg, dest, buffer_type(send_buffer, size,
+                buffer_type::reference)).then(&reply_time<buffer_type>));
+        }
+        hpx::wait_all(replies);
+
+        // one way latency of every message in this iteration
+        for(std::size_t j = 0; j < window_size; ++j)
+        {
+            boost::uint64_t arrived = replies[j].get();
+            if (i >= skip)
+                hist.record((arrived - sent[j]) / 2);
         }
-        hpx::wait_all(recv_buffers);
-        recv_buffers.clear();
+        replies.clear();
+        sent.clear();
     }
 
     double elapsed = t.elapsed();
@@ -90,9 +106,8 @@ double receive(
 ///////////////////////////////////////////////////////////////////////////////
 void print_header ()
 {
-    hpx::cout << "# OSU HPX Latency Test\n"
-              << "# Size    Latency (microsec)\n"
-              << hpx::flush;
+    hpx::cout << "# OSU HPX Latency Test\n" << hpx::flush;
+    print_latency_header();
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -123,9 +138,9 @@ void run_benchmark(boost::program_options::variables_map & vm)
     // perform actual measurements
     for (std::size_t size = min_size; size <= max_size; size *= 2)
     {
-        double latency = receive(there, send_buffer, size, loop, window_size);
-        hpx::cout << std::left << std::setw(10) << size
-                  << latency << hpx::endl << hpx::flush;
+        latency_histogram hist;
+        double latency = receive(there, send_buffer, size, loop, window_size, hist);
+        print_latency(size, latency, hist);
     }
     hpx::cout << "Total time: " << timer.elapsed_nanoseconds() << "\n" << hpx::flush;
     delete[] send_buffer_orig;
@@ -0,0 +1,158 @@
+//  Copyright (c) 2013 Hartmut Kaiser
+//  Copyright (c) 2013 Thomas Heller
+//  Copyright (c) 2026 The STE||AR Group
+//
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+// Multiple bandwidth / message rate test
+
+#include <hpx/hpx_main.hpp>
+#include <hpx/hpx.hpp>
+#include <hpx/include/iostreams.hpp>
+#include <hpx/util/serialize_buffer.hpp>
+
+#include <boost/assert.hpp>
+#include <boost/shared_ptr.hpp>
+
+#include <algorithm>
+
+///////////////////////////////////////////////////////////////////////////////
+char* align_buffer (char* ptr, unsigned long align_size)
+{
+    return (char*)(((std::size_t)ptr + (align_size - 1)) / align_size * align_size);
+}
+
+#if defined(BOOST_MSVC)
+unsigned long getpagesize()
+{
+    SYSTEM_INFO si;
+    GetSystemInfo(&si);
+    return si.dwPageSize;
+}
+#endif
+
+///////////////////////////////////////////////////////////////////////////////
+#define LOOP_SMALL  100
+#define SKIP_SMALL  10
+
+#define LOOP_LARGE  20
+#define SKIP_LARGE  2
+
+#define LARGE_MESSAGE_SIZE  8192
+
+#define MAX_ALIGNMENT 65536
+
+///////////////////////////////////////////////////////////////////////////////
+void isend(hpx::util::serialize_buffer<char> const& receive_buffer) {}
+HPX_PLAIN_ACTION(isend);
+
+///////////////////////////////////////////////////////////////////////////////
+// Stream windows of messages to dest, returns the time in seconds it took
+// to send loop windows after the warm up phase.
+double ireceive(hpx::naming::id_type dest, std::size_t size, std::size_t window_size)
+{
+    std::size_t loop = LOOP_SMALL;
+    std::size_t skip = SKIP_SMALL;
+
+    if (size > LARGE_MESSAGE_SIZE) {
+        loop = LOOP_LARGE;
+        skip = SKIP_LARGE;
+    }
+
+    // align used buffers on page boundaries
+    unsigned long align_size = getpagesize();
+    BOOST_ASSERT(align_size <= MAX_ALIGNMENT);
+
+    char *send_buffer_orig = new char[size + align_size];
+    char *send_buffer = align_buffer(send_buffer_orig, align_size);
+    std::memset(send_buffer, 'a', size);
+
+    hpx::util::high_resolution_timer t;
+
+    std::vector<hpx::future<void> > lazy_results;
+    lazy_results.reserve(window_size);
+    isend_action send;
+    for (std::size_t i = 0; i != loop + skip; ++i) {
+        // do not measure warm up phase
+        if (i == skip)
+            t.restart();
+
+        for (std::size_t j = 0; j < window_size; ++j)
+        {
+            typedef hpx::util::serialize_buffer<char> buffer_type;
+
+            // Note: The original benchmark uses MPI_Isend which does not
+            //       create a copy of the passed buffer.
+            lazy_results.push_back(hpx::async(send, dest,
+                buffer_type(send_buffer, size, buffer_type::reference)));
+        }
+        hpx::wait_all(lazy_results);
+        lazy_results.clear();
+    }
+
+    double elapsed = t.elapsed();
+
+    delete[] send_buffer_orig;
+
+    return elapsed;
+}
+HPX_PLAIN_ACTION(ireceive);
+
+///////////////////////////////////////////////////////////////////////////////
+void print_header()
+{
+    hpx::cout << "# OSU HPX Multiple Bandwidth / Message Rate Test\n"
+              << "# Size    MB/s          Messages/s\n"
+              << hpx::flush;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+void run_benchmark(boost::program_options::variables_map & vm)
+{
+    std::vector<hpx::id_type> localities = hpx::find_all_localities();
+
+    // the first half of the localities sends to the second half, with a
+    // single locality it sends to itself
+    std::size_t pairs = localities.size() / 2;
+    if (pairs == 0)
+    {
+        pairs = 1;
+        localities.push_back(localities[0]);
+    }
+
+    std::size_t window_size = vm["window-size"].as<std::size_t>();
+    std::size_t min_size = (std::max)(vm["min-size"].as<std::size_t>(), std::size_t(1));
+    std::size_t max_size = vm["max-size"].as<std::size_t>();
+
+    for (std::size_t size = min_size; size <= max_size; size *= 2)
+    {
+        std::vector<hpx::future<double> > benchmarks;
+        benchmarks.reserve(pairs);
+
+        for (std::size_t i = 0; i != pairs; ++i)
+        {
+            ireceive_action receive;
+            benchmarks.push_back(hpx::async(receive,
+                localities[i], localities[i + pairs], size, window_size));
+        }
+
+        hpx::wait_all(benchmarks);
+
+        // the pairs run concurrently, the slowest one determines the rate
+        double elapsed = 0;
+        BOOST_FOREACH(hpx::future<double> & f, benchmarks)
+        {
+            elapsed = (std::max)(elapsed, f.get());
+        }
+
+        std::size_t loop = size > LARGE_MESSAGE_SIZE ? LOOP_LARGE : LOOP_SMALL;
+        double messages = static_cast<double>(pairs * loop * window_size);
+        double rate = messages / elapsed;
+
+        hpx::cout << std::left << std::setw(10) << size
+                  << std::setw(14) << rate * size / 1e6
+                  << rate
+                  << hpx::endl << hpx::flush;
+    }
+}
@@ -0,0 +1,135 @@
+//  Copyright (c) 2013 Hartmut Kaiser
+//  Copyright (c) 2013 Thomas Heller
+//  Copyright (c) 2026 The STE||AR Group
+//
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+// Multi-threaded unidirectional network bandwidth test
+
+#include <hpx/hpx_main.hpp>
+#include <hpx/hpx.hpp>
+#include <hpx/include/iostreams.hpp>
+#include <hpx/util/serialize_buffer.hpp>
+
+#include <boost/assert.hpp>
+#include <boost/shared_ptr.hpp>
+
+#include <algorithm>
+
+///////////////////////////////////////////////////////////////////////////////
+#define LOOP_SMALL  100
+#define SKIP_SMALL  10
+
+#define LOOP_LARGE  20
+#define SKIP_LARGE  2
+
+#define LARGE_MESSAGE_SIZE  8192
+
+///////////////////////////////////////////////////////////////////////////////
+void isend(hpx::util::serialize_buffer<char> const& receive_buffer) {}
+HPX_PLAIN_ACTION(isend);
+
+///////////////////////////////////////////////////////////////////////////////
+// Executed by each of the sending HPX threads: streams windows of messages
+// from its own buffer to dest, returns the time in seconds it took to send
+// loop windows after the warm up phase.
+double send_windows(hpx::naming::id_type dest, std::size_t size, std::size_t window_size)
+{
+    std::size_t loop = LOOP_SMALL;
+    std::size_t skip = SKIP_SMALL;
+
+    if (size > LARGE_MESSAGE_SIZE) {
+        loop = LOOP_LARGE;
+        skip = SKIP_LARGE;
+    }
+
+    std::vector<char> send_buffer(size, 'a');
+
+    hpx::util::high_resolution_timer t;
+
+    std::vector<hpx::future<void> > lazy_results;
+    lazy_results.reserve(window_size);
+    isend_action send;
+    for (std::size_t i = 0; i != loop + skip; ++i) {
+        // do not measure warm up phase
+        if (i == skip)
+            t.restart();
+
+        for (std::size_t j = 0; j < window_size; ++j)
+        {
+            typedef hpx::util::serialize_buffer<char> buffer_type;
+
+            // Note: The original benchmark uses MPI_Isend which does not
+            //       create a copy of the passed buffer.
+            lazy_results.push_back(hpx::async(send, dest,
+                buffer_type(&send_buffer[0], size, buffer_type::reference)));
+        }
+        hpx::wait_all(lazy_results);
+        lazy_results.clear();
+    }
+
+    return t.elapsed();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+void print_header()
+{
+    hpx::cout << "# OSU HPX Multi-threaded Bandwidth Test\n"
+              << "# Size    Threads   MB/s          Messages/s\n"
+              << "#         (Threads is the number of HPX threads sending a window each)\n"
+              << hpx::flush;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+void run_benchmark(boost::program_options::variables_map & vm)
+{
+    // use the first remote locality to bounce messages, if possible
+    hpx::id_type here = hpx::find_here();
+
+    hpx::id_type there = here;
+    std::vector<hpx::id_type> localities = hpx::find_remote_localities();
+    if (!localities.empty())
+        there = localities[0];
+
+    std::size_t window_size = vm["window-size"].as<std::size_t>();
+    std::size_t min_size = (std::max)(vm["min-size"].as<std::size_t>(), std::size_t(1));
+    std::size_t max_size = vm["max-size"].as<std::size_t>();
+    std::size_t max_threads = hpx::get_os_thread_count();
+
+    for (std::size_t size = min_size; size <= max_size; size *= 2)
+    {
+        // 1, 2, 4, ... senders, and all OS threads at last
+        for (std::size_t threads = 1; threads <= max_threads;
+             threads = (threads * 2 > max_threads && threads != max_threads)
+                ? max_threads : threads * 2)
+        {
+            std::vector<hpx::future<double> > senders;
+            senders.reserve(threads);
+
+            for (std::size_t i = 0; i != threads; ++i)
+            {
+                senders.push_back(hpx::async(&send_windows, there, size, window_size));
+            }
+
+            hpx::wait_all(senders);
+
+            // the senders run concurrently, the slowest one determines the rate
+            double elapsed = 0;
+            BOOST_FOREACH(hpx::future<double> & f, senders)
+            {
+                elapsed = (std::max)(elapsed, f.get());
+            }
+
+            std::size_t loop = size > LARGE_MESSAGE_SIZE ? LOOP_LARGE : LOOP_SMALL;
+            double messages = static_cast<double>(threads * loop * window_size);
+            double rate = messages / elapsed;
+
+            hpx::cout << std::left << std::setw(10) << size
+                      << std::setw(10) << threads
+                      << std::setw(14) << rate * size / 1e6
+                      << rate
+                      << hpx::endl << hpx::flush;
+        }
+    }
+}
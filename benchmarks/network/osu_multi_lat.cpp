@@ -9,11 +9,17 @@
 #include <hpx/hpx_main.hpp>
 #include <hpx/hpx.hpp>
 #include <hpx/include/iostreams.hpp>
+#include <hpx/util/high_resolution_clock.hpp>
 #include <hpx/util/serialize_buffer.hpp>
 
+#include <benchmarks/network/latency_histogram.hpp>
+
 #include <boost/assert.hpp>
+#include <boost/serialization/utility.hpp>
 #include <boost/shared_ptr.hpp>
 
+#include <utility>
+
 ///////////////////////////////////////////////////////////////////////////////
 #define LOOP_SMALL  10000
 #define SKIP_SMALL  1000
@@ -53,7 +59,10 @@ isend(hpx::util::serialize_buffer<char> const& receive_buffer)
 HPX_PLAIN_ACTION(isend);
 
 ///////////////////////////////////////////////////////////////////////////////
-double ireceive(hpx::naming::id_type dest, std::size_t size, std::size_t window_size)
+// returns the mean one way latency over all windows in microseconds and the
+// histogram of the one way latency of each message
+std::pair<double, latency_histogram>
+ireceive(hpx::naming::id_type dest, std::size_t size, std::size_t window_size)
 {
     int loop = LOOP_SMALL;
     int skip = SKIP_SMALL;
@@ -70,38 +79,51 @@ double ireceive(hpx::naming::id_type dest, std::size_t size, std::size_t window_
     char* aligned_send_buffer = align_buffer(send_buffer, align_size);
     std::memset(aligned_send_buffer, 'a', size);
 
+    latency_histogram hist;
     hpx::util::high_resolution_timer t;
 
+    typedef hpx::util::serialize_buffer<char> buffer_type;
+    std::vector<hpx::future<boost::uint64_t> > replies;
+    std::vector<boost::uint64_t> sent;
+    replies.reserve(window_size);
+    sent.reserve(window_size);
+
     isend_action send;
     for (int i = 0; i != loop + skip; ++i) {
         // do not measure warm up phase
         if (i == skip)
             t.restart();
 
-        typedef hpx::util::serialize_buffer<char> buffer_type;
-        std::vector<hpx::future<buffer_type> > send_futures;
-        send_futures.reserve(window_size);
         for(std::size_t j = 0; j < window_size; ++j)
         {
-            send_futures.push_back(
+            sent.push_back(hpx::util::high_resolution_clock::now());
+            replies.push_back(
                 hpx::async(send, dest, buffer_type(aligned_send_buffer, size,
-                    buffer_type::reference))
+                    buffer_type::reference)).then(&reply_time<buffer_type>)
             );
         }
-        hpx::wait_all(send_futures);
+        hpx::wait_all(replies);
+
+        for(std::size_t j = 0; j < window_size; ++j)
+        {
+            boost::uint64_t arrived = replies[j].get();
+            if (i >= skip)
+                hist.record((arrived - sent[j]) / 2);
+        }
+        replies.clear();
+        sent.clear();
     }
 
-    double elapsed = t.elapsed();
-    return (elapsed * 1e6) / (2 * loop * window_size);
+    double latency = (t.elapsed() * 1e6) / (2 * loop * window_size);
+    return std::make_pair(latency, hist);
 }
 HPX_PLAIN_ACTION(ireceive);
 
 ///////////////////////////////////////////////////////////////////////////////
 void print_header()
 {
-    hpx::cout << "# OSU HPX Multi Latency Test\n"
-              << "# Size    Latency (microsec)\n"
-              << hpx::flush;
+    hpx::cout << "# OSU HPX Multi Latency Test\n" << hpx::flush;
+    print_latency_header();
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -113,7 +135,7 @@ void run_benchmark(boost::program_options::variables_map & vm)
 
     for (std::size_t size = 1; size <= MAX_MSG_SIZE; size *= 2)
     {
-        std::vector<hpx::future<double> > benchmarks;
+        std::vector<hpx::future<std::pair<double, latency_histogram> > > benchmarks;
 
         for (boost::uint32_t locality_id = 0; locality_id != localities.size(); ++locality_id) 
         {
@@ -130,15 +152,17 @@ void run_benchmark(boost::program_options::variables_map & vm)
         }
 
         double total_latency = 0;
+        latency_histogram hist;
 
         hpx::wait_all(benchmarks);
-        BOOST_FOREACH(hpx::future<double> & f, benchmarks)
+        typedef std::pair<double, latency_histogram> result_type;
+        BOOST_FOREACH(hpx::future<result_type> & f, benchmarks)
         {
-            total_latency += f.get();
+            result_type r = f.get();
+            total_latency += r.first;
+            hist += r.second;
         }
 
-        hpx::cout << std::left << std::setw(10) << size
-                  << total_latency / (2. * pairs)
-                  << hpx::endl << hpx::flush;
+        print_latency(size, total_latency / (2. * pairs), hist);
     }
 }
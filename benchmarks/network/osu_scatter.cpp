@@ -15,41 +15,43 @@
 
 #include <benchmarks/network/osu_coll.hpp>
 
-void scatter(std::vector<hpx::id_type> const & localities, hpx::util::serialize_buffer<char> buffer, std::size_t chunk_size);
+typedef hpx::util::serialize_buffer<char> buffer_type;
+
+void scatter(std::vector<hpx::id_type> const & localities, buffer_type const & buffer, std::size_t fan_out);
 HPX_PLAIN_ACTION(scatter);
 
-void scatter(std::vector<hpx::id_type> const & localities, hpx::util::serialize_buffer<char> buffer, std::size_t chunk_size)
+// buffer holds one equally sized slice for every locality, in the order of
+// localities. localities[0] is this locality and keeps the first slice, the
+// others are split into fan_out contiguous subtrees, each of which is sent
+// only the slices of its own localities. The slices are views into buffer,
+// so they are copied only when they are sent over the wire.
+void scatter(std::vector<hpx::id_type> const & localities, buffer_type const & buffer, std::size_t fan_out)
 {
-    std::vector<hpx::future<void> > scatter_futures;
-    scatter_futures.reserve(localities.size() / chunk_size);
+    std::size_t slice_size = buffer.size() / localities.size();
+    std::size_t num_dests = localities.size() - 1;
+    std::size_t num_subtrees = (std::min)((std::max)(fan_out, std::size_t(1)), num_dests);
 
-    typedef std::vector<hpx::id_type>::const_iterator iterator;
-    iterator begin = localities.cbegin() + 1;
+    std::vector<hpx::future<void> > scatter_futures;
+    scatter_futures.reserve(num_subtrees);
 
-    if(localities.size() > 1)
+    char * data = const_cast<char *>(buffer.data());
+    for(std::size_t i = 0; i < num_subtrees; ++i)
     {
-        for(std::size_t i = 0; i < chunk_size; ++i)
-        {
-            iterator end
-                = (i == chunk_size-1)
-                ? localities.cend()
-                : begin + (localities.size() - 1)/chunk_size + 1;
-
-            std::vector<hpx::id_type> locs(begin, end);
-            if(locs.size() > 0)
-            {
-                hpx::id_type dst = locs[0];
-
-                scatter_futures.push_back(
-                    hpx::async<scatter_action>(dst, boost::move(locs), buffer, chunk_size)
-                );
-            }
-
-            begin = end;
-        }
+        std::size_t begin = 1 + (i * num_dests) / num_subtrees;
+        std::size_t end = 1 + ((i + 1) * num_dests) / num_subtrees;
+
+        std::vector<hpx::id_type> locs(localities.begin() + begin, localities.begin() + end);
+        hpx::id_type dst = locs[0];
+
+        scatter_futures.push_back(
+            hpx::async<scatter_action>(dst, boost::move(locs),
+                buffer_type(data + begin * slice_size, (end - begin) * slice_size,
+                    buffer_type::reference),
+                fan_out)
+        );
     }
 
-    // Call some action for this locality here ...
+    // The first slice of buffer is the one for this locality ...
 
     if(scatter_futures.size() > 0)
     {
@@ -70,7 +72,8 @@ void run_benchmark(params const & p)
         return;
     }
 
-    std::vector<char> send_buffer(p.max_msg_size);
+    // one slice of up to max_msg_size bytes per locality
+    std::vector<char> send_buffer(p.max_msg_size * localities.size());
 
     for(std::size_t size = 1; size <= p.max_msg_size; size *=2)
     {
@@ -80,20 +83,24 @@ void run_benchmark(params const & p)
             iterations = ITERATIONS_LARGE;
         }
 
+        std::size_t total_size = size * localities.size();
 
         double elapsed = 0.0;
         for(std::size_t i = 0; i < iterations + skip; ++i)
         {
             hpx::util::high_resolution_timer t;
-            typedef hpx::util::serialize_buffer<char> buffer_type;
             hpx::id_type dst = localities[0];
-            scatter_action()(dst, localities, buffer_type(&send_buffer[0], size, buffer_type::reference), p.chunk_size);
+            scatter_action()(dst, localities,
+                buffer_type(&send_buffer[0], total_size, buffer_type::reference), p.fan_out);
             double t_elapsed = t.elapsed();
             if(i >= skip)
                 elapsed += t_elapsed;
         }
 
-        print_data(elapsed, size, iterations);
+        hpx::cout << std::left << std::setw(10) << size
+                  << std::setw(14) << total_size
+                  << (elapsed * 1e6) / iterations
+                  << hpx::endl << hpx::flush;
     }
 }
 
@@ -101,7 +108,11 @@ void run_benchmark(params const & p)
 int hpx_main(boost::program_options::variables_map & vm)
 {
     params p(process_args(vm));
-    print_header("OSU HPX Scatter Latency Test");
+    hpx::cout << "# OSU HPX Scatter Latency Test" << hpx::endl
+              << "# Size    Total size    Latency (microsec)" << hpx::endl
+              << "#         (Size is the slice of one locality, Total size the buffer of the root)"
+                 << hpx::endl
+              << hpx::flush;
     run_benchmark(p);
     return hpx::finalize();
 }
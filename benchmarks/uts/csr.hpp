@@ -0,0 +1,186 @@
+//  Copyright (c) 2026 The STE||AR Group
+//
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef BENCHMARKS_UTS_CSR_HPP
+#define BENCHMARKS_UTS_CSR_HPP
+
+#include <boost/cstdint.hpp>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// Explicit trees are stored in a binary CSR (compressed sparse row) file in
+// host byte order:
+//
+//   csr_header
+//   boost::uint64_t offsets[num_nodes + 1]
+//   boost::uint64_t children[num_edges]
+//
+// The children of node i are children[offsets[i]] .. children[offsets[i+1] - 1].
+#define UTS_CSR_MAGIC "UTSCSR01"
+
+struct csr_header
+{
+    char magic[8];
+    boost::uint64_t num_nodes;
+    boost::uint64_t num_edges;
+    boost::uint64_t root;
+};
+
+inline void write_csr(std::string const & filename, boost::uint64_t root,
+    std::vector<boost::uint64_t> const & offsets,
+    std::vector<boost::uint64_t> const & children)
+{
+    if(offsets.empty() || offsets.back() != children.size())
+    {
+        throw std::logic_error("write_csr(): offsets don't match children");
+    }
+
+    std::ofstream os(filename.c_str(), std::ios::binary);
+    if(!os)
+    {
+        throw std::logic_error("write_csr(): could not open " + filename);
+    }
+
+    csr_header header;
+    std::memcpy(header.magic, UTS_CSR_MAGIC, sizeof(header.magic));
+    header.num_nodes = offsets.size() - 1;
+    header.num_edges = children.size();
+    header.root = root;
+
+    os.write(reinterpret_cast<char const *>(&header), sizeof(header));
+    os.write(reinterpret_cast<char const *>(&offsets[0]),
+        offsets.size() * sizeof(boost::uint64_t));
+    if(!children.empty())
+    {
+        os.write(reinterpret_cast<char const *>(&children[0]),
+            children.size() * sizeof(boost::uint64_t));
+    }
+
+    if(!os)
+    {
+        throw std::logic_error("write_csr(): could not write " + filename);
+    }
+}
+
+// Read only memory mapping of a CSR file. The pages are shared between all
+// stealstacks of a locality, traversing the tree costs memory accesses
+// instead of rng_spawns.
+struct csr_tree
+{
+    csr_tree()
+      : offsets(0)
+      , children(0)
+      , header(0)
+    {}
+
+    void open(std::string const & filename)
+    {
+        using namespace boost::interprocess;
+
+        file_mapping file(filename.c_str(), read_only);
+        mapped_region region(file, read_only);
+
+        if(region.get_size() < sizeof(csr_header))
+        {
+            throw std::logic_error("csr_tree::open(): " + filename + " is too small");
+        }
+
+        csr_header const * h = static_cast<csr_header const *>(region.get_address());
+        if(std::memcmp(h->magic, UTS_CSR_MAGIC, sizeof(h->magic)) != 0)
+        {
+            throw std::logic_error("csr_tree::open(): " + filename + " is not a CSR file");
+        }
+        boost::uint64_t words = (region.get_size() - sizeof(csr_header)) / sizeof(boost::uint64_t);
+        if(h->num_nodes >= words || h->num_edges > words
+            || region.get_size() != sizeof(csr_header)
+                + (h->num_nodes + 1 + h->num_edges) * sizeof(boost::uint64_t))
+        {
+            throw std::logic_error("csr_tree::open(): " + filename + " is truncated");
+        }
+
+        // the traversal trusts the structure, so check it once here
+        boost::uint64_t const * o = reinterpret_cast<boost::uint64_t const *>(h + 1);
+        boost::uint64_t const * c = o + h->num_nodes + 1;
+        if(h->num_nodes == 0 || h->root >= h->num_nodes)
+        {
+            throw std::logic_error("csr_tree::open(): " + filename + " has no valid root");
+        }
+        if(o[0] != 0 || o[h->num_nodes] != h->num_edges)
+        {
+            throw std::logic_error("csr_tree::open(): " + filename
+                + " has offsets which don't match its edges");
+        }
+        for(boost::uint64_t i = 0; i < h->num_nodes; ++i)
+        {
+            if(o[i + 1] < o[i])
+            {
+                throw std::logic_error("csr_tree::open(): " + filename
+                    + " has offsets which are not monotonic");
+            }
+            if(o[i + 1] - o[i] > static_cast<boost::uint64_t>(std::numeric_limits<int>::max()))
+            {
+                throw std::logic_error("csr_tree::open(): " + filename
+                    + " has a node with too many children");
+            }
+        }
+        for(boost::uint64_t k = 0; k < h->num_edges; ++k)
+        {
+            if(c[k] >= h->num_nodes)
+            {
+                throw std::logic_error("csr_tree::open(): " + filename
+                    + " has a child index out of range");
+            }
+        }
+
+        file_.swap(file);
+        region_.swap(region);
+
+        header = h;
+        offsets = o;
+        children = c;
+    }
+
+    bool is_open() const
+    {
+        return header != 0;
+    }
+
+    boost::uint64_t num_nodes() const
+    {
+        return header->num_nodes;
+    }
+
+    boost::uint64_t root() const
+    {
+        return header->root;
+    }
+
+    int num_children(boost::uint64_t i) const
+    {
+        return static_cast<int>(offsets[i + 1] - offsets[i]);
+    }
+
+    boost::uint64_t child(boost::uint64_t i, int j) const
+    {
+        return children[offsets[i] + j];
+    }
+
+private:
+    boost::interprocess::file_mapping file_;
+    boost::interprocess::mapped_region region_;
+
+    boost::uint64_t const * offsets;
+    boost::uint64_t const * children;
+    csr_header const * header;
+};
+
+#endif
@@ -0,0 +1,107 @@
+//  Copyright (c) 2026 The STE||AR Group
+//
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef BENCHMARKS_UTS_LOAD_TABLE_HPP
+#define BENCHMARKS_UTS_LOAD_TABLE_HPP
+
+#include <hpx/hpx.hpp>
+#include <hpx/lcos/local/spinlock.hpp>
+
+#include <boost/cstdint.hpp>
+#include <boost/random/mersenne_twister.hpp>
+#include <boost/random/uniform_01.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+#include <vector>
+
+// Approximate queue depth of every stealstack. There are no extra messages:
+// the entries are updated from the loads piggybacked on steal requests,
+// steal replies, shares and share acknowledgements, and may therefore be
+// arbitrarily stale.
+struct load_table
+{
+    typedef hpx::lcos::local::spinlock mutex_type;
+
+    load_table()
+      : rank(0)
+    {}
+
+    void init(std::size_t r, std::size_t size)
+    {
+        mutex_type::scoped_lock lk(mtx);
+        rank = r;
+        loads.assign(size, 0);
+        gen.seed(static_cast<boost::uint32_t>(r + 1));
+    }
+
+    void update(std::size_t r, std::size_t load)
+    {
+        mutex_type::scoped_lock lk(mtx);
+        if(r < loads.size()) loads[r] = load;
+    }
+
+    void add(std::size_t r, std::size_t load)
+    {
+        mutex_type::scoped_lock lk(mtx);
+        if(r < loads.size()) loads[r] += load;
+    }
+
+    // All other stealstacks, in an order sampled without replacement with
+    // probabilities proportional to their advertised load plus one. Ranks
+    // believed to be empty still get visited, which keeps termination
+    // detection intact and lets the table recover from stale entries.
+    std::vector<std::size_t> victim_order()
+    {
+        mutex_type::scoped_lock lk(mtx);
+
+        // weighted sampling without replacement by sorting the keys
+        // log(u)/w (Efraimidis and Spirakis)
+        boost::random::uniform_01<double> u01;
+        std::vector<std::pair<double, std::size_t> > keys;
+        keys.reserve(loads.size());
+        for(std::size_t i = 0; i < loads.size(); ++i)
+        {
+            if(i == rank) continue;
+            double u = u01(gen);
+            if(u == 0.0) u = 1e-300;
+            keys.push_back(std::make_pair(std::log(u) / (loads[i] + 1.0), i));
+        }
+        std::sort(keys.begin(), keys.end());
+
+        std::vector<std::size_t> order;
+        order.reserve(keys.size());
+        for(std::size_t i = keys.size(); i > 0; --i)
+        {
+            order.push_back(keys[i - 1].second);
+        }
+        return order;
+    }
+
+    // The other stealstack with the smallest advertised load, ties are
+    // broken round robin starting after last
+    std::size_t least_loaded(std::size_t last)
+    {
+        mutex_type::scoped_lock lk(mtx);
+
+        std::size_t size = loads.size();
+        std::size_t res = rank;
+        for(std::size_t i = 1; i <= size; ++i)
+        {
+            std::size_t r = (last + i) % size;
+            if(r == rank) continue;
+            if(res == rank || loads[r] < loads[res]) res = r;
+        }
+        return res;
+    }
+
+    mutex_type mtx;
+    std::size_t rank;
+    std::vector<std::size_t> loads;
+    boost::random::mt19937 gen;
+};
+
+#endif
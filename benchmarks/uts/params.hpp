@@ -10,15 +10,70 @@
 #include <benchmarks/uts/rng/rng.h>
 #include <benchmarks/uts/uts.hpp>
 
+#if !defined(UTS_NO_HPX)
 #include <hpx/hpx_init.hpp>
 #include <hpx/hpx.hpp>
 #include <hpx/include/iostreams.hpp>
 #include <hpx/components/distributing_factory/distributing_factory.hpp>
+#endif
+
+#include <boost/program_options.hpp>
 
+#include <algorithm>
 #include <cmath>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#if !defined(HPX_APPLICATION_STRING)
+#define HPX_APPLICATION_STRING "uts"
+#endif
+
+// parse a comma separated list of ranks and rank ranges, e.g. "0,4-7"
+inline std::vector<std::size_t> parse_rank_list(std::string const & list)
+{
+    std::vector<std::size_t> ranks;
+    std::istringstream is(list);
+    std::string item;
+    while(std::getline(is, item, ','))
+    {
+        if(item.empty()) continue;
+
+        std::size_t first = 0, last = 0;
+        char dash = 0;
+        std::istringstream item_is(item);
+        item_is >> first;
+        if(item_is.fail())
+        {
+            throw std::logic_error("parse_rank_list(): invalid rank list: " + list);
+        }
+        last = first;
+        if(item_is >> dash)
+        {
+            if(dash != '-' || !(item_is >> last) || last < first)
+            {
+                throw std::logic_error("parse_rank_list(): invalid rank list: " + list);
+            }
+        }
+        for(std::size_t r = first; r <= last; ++r)
+        {
+            ranks.push_back(r);
+        }
+    }
+    std::sort(ranks.begin(), ranks.end());
+    ranks.erase(std::unique(ranks.begin(), ranks.end()), ranks.end());
+    return ranks;
+}
 
 struct params
 {
+    enum steal_policy_type
+    {
+        STEAL_ROUND_ROBIN   = 0,    // visit the other stealstacks in turn
+        STEAL_LOAD_WEIGHTED = 1     // prefer stealstacks advertising a high load
+    };
+
     params()
     {}
 
@@ -32,25 +87,80 @@ struct params
       , non_leaf_bf(vm["num-children"].as<int>())
       , shift_depth(vm["fraction-of-depth"].as<double>())
       , compute_granularity(vm["compute-granularity"].as<int>())
+      , cost_dist(vm["cost-distribution"].as<node::cost_distribution>())
+      , cost_heavy_fraction(vm["cost-heavy-fraction"].as<double>())
+      , cost_heavy_factor(vm["cost-heavy-factor"].as<double>())
+      , cost_pareto_alpha(vm["cost-pareto-alpha"].as<double>())
+      , cost_pareto_scale(0.0)
+      , balance_by_cost(vm["balance-by-cost"].as<int>() != 0)
       , chunk_size(vm["chunk-size"].as<std::size_t>())
+      , payload_bytes(vm["node-payload-bytes"].as<std::size_t>())
+      , slow_ranks(parse_rank_list(vm["slow-ranks"].as<std::string>()))
+      , slowdown(vm["slowdown"].as<double>())
+      , slow_sleep(vm["slow-sleep"].as<int>())
+      , share_batch(vm["share-batch"].as<std::size_t>())
+      , share_batch_window(vm["share-batch-window"].as<int>())
+      , steal_policy(vm["steal-policy"].as<int>() == STEAL_LOAD_WEIGHTED
+            ? STEAL_LOAD_WEIGHTED : STEAL_ROUND_ROBIN)
       , polling_interval(vm["interval"].as<int>())
       , verbose(vm["verbose"].as<int>())
       , debug(vm["debug"].as<int>())
-    {}
+      , trace_buffer_size(vm["trace-buffer-size"].as<std::size_t>())
+      , csr_file(vm["csr-file"].as<std::string>())
+      , queue_memory_cap(vm["queue-memory-cap"].as<std::size_t>())
+      , reduce(vm["reduce"].as<int>() != 0)
+      , max_nodes(0)
+    {
+        if(cost_dist == node::PARETO_COST)
+        {
+            // the mean of a Pareto distribution is finite for alpha > 1 only
+            if(!(cost_pareto_alpha > 1.0))
+            {
+                throw std::logic_error("params(): --cost-pareto-alpha must be greater than 1");
+            }
+            cost_pareto_scale = node::pareto_scale(cost_pareto_alpha);
+        }
+    }
+
+    // for the traversals which don't attach payloads to their nodes, so that
+    // the printed configuration is the one which actually ran
+    void disable_payload()
+    {
+        if(payload_bytes == 0) return;
 
+        UTS_COUT
+            << "--node-payload-bytes is not supported by this traversal, ignored\n"
+            << UTS_FLUSH;
+        payload_bytes = 0;
+    }
+
+#if !defined(UTS_NO_HPX)
     void print(const char * name) const
     {
         if(verbose == 0) return;
 
-        hpx::cout
+        hpx::lcos::future<boost::uint32_t> locs = hpx::get_num_localities();
+        print(name, hpx::get_num_worker_threads(), locs.get());
+    }
+#endif
+
+    void print(const char * name, std::size_t num_threads, std::size_t num_localities) const
+    {
+        if(verbose == 0) return;
+
+        UTS_COUT
+#if defined(UTS_NO_HPX)
+            << "UTS - Unbalanced Tree Search 0.1 (" << name << ")\n"
+#else
             << "UTS - Unbalanced Tree Search 0.1 (HPX " << name << ")\n"
+#endif
             << "Tree type: " << static_cast<int>(type) << " (" << type << ")\n"
             << "Tree shape parameters:\n"
             << "  root branching factor b_0 = " << b_0 << ", root seed = " << root_id << "\n";
 
         if(type == node::GEO || type == node::HYBRID)
         {
-            hpx::cout
+            UTS_COUT
                 << "  GEO parameters: "
                 << "gen_mx = " << gen_mx
                 << ", shape function = " << static_cast<int>(shape_fn) << " (" << shape_fn << ")\n";
@@ -62,41 +172,76 @@ struct params
             int m = non_leaf_bf;
             double es = (1.0 / (1.0 - q * m));
 
-            hpx::cout
+            UTS_COUT
                 << "  BIN parameters: "
                 << "q = " << q << ", m = " << m << ", E(n) = " << q * m << ", E(s) = " << es << "\n";
         }
 
         if(type == node::HYBRID)
         {
-            hpx::cout
+            UTS_COUT
                 << "  HYBRID: GEO from root to depth " << std::ceil(shift_depth * gen_mx) << ", then BIN\n";
         }
 
         if(type == node::BALANCED)
         {
-            hpx::cout
+            UTS_COUT
                 << "  BALANCED parameters: gen_mx = " << gen_mx << "\n"
                 << "        Expected size: " << (std::pow(b_0, gen_mx + 1) - 1.0)/(b_0 - 1.0) << " nodes, "
                 << std::pow(b_0, gen_mx) << " leaves\n";
         }
 
-        std::size_t num_threads = hpx::get_num_worker_threads();
+        if(!csr_file.empty())
+        {
+            UTS_COUT
+                << "Explicit tree: " << csr_file << " (CSR), tree shape parameters are ignored\n";
+        }
 
         // random number generator
         char strBuf[1024];
         rng_showtype(strBuf, 0);
 
-        hpx::lcos::future<boost::uint32_t> locs = hpx::get_num_localities();
-        hpx::cout
+        UTS_COUT
             << "Random number generator: " << strBuf << "\n"
-            << "Compute granularity: " << compute_granularity << "\n"
+            << "Compute granularity: " << compute_granularity
+                << ", cost distribution: " << cost_dist << "\n"
             << "Execution strategy: "
-            << "Parallel search using " << locs.get() << " localities "
+            << "Parallel search using " << num_localities << " localities "
             << "with a total of " << num_threads << " threads\n"
-            << "Load balance by " << name << ", chunk size = " << chunk_size << " nodes\n"
+            << "Load balance by " << name << ", chunk size = " << chunk_size << " nodes"
+                << (balance_by_cost ? ", balancing estimated cost\n" : "\n")
+            << "Node payload: " << payload_bytes << " bytes\n"
+            << UTS_FLUSH;
+
+        if(!slow_ranks.empty())
+        {
+            UTS_COUT << "Slow stealstacks:";
+            BOOST_FOREACH(std::size_t r, slow_ranks)
+            {
+                UTS_COUT << " " << r;
+            }
+            UTS_COUT
+                << " (compute x " << slowdown << ", sleep "
+                << slow_sleep << " us per chunk)\n"
+                << UTS_FLUSH;
+        }
+
+        UTS_COUT
+            << "Steal policy: "
+                << (steal_policy == STEAL_LOAD_WEIGHTED ? "load weighted" : "round robin") << "\n"
             << "Polling Interval: " << polling_interval << "\n\n"
-            << hpx::flush;
+            << UTS_FLUSH;
+    }
+
+    bool is_slow(std::size_t rank) const
+    {
+        return std::binary_search(slow_ranks.begin(), slow_ranks.end(), rank);
+    }
+
+    // mean of node::cost
+    double expected_cost() const
+    {
+        return compute_granularity;
     }
 
     template <typename Archive>
@@ -111,10 +256,28 @@ struct params
         ar & non_leaf_bf;
         ar & shift_depth;
         ar & compute_granularity;
+        ar & cost_dist;
+        ar & cost_heavy_fraction;
+        ar & cost_heavy_factor;
+        ar & cost_pareto_alpha;
+        ar & cost_pareto_scale;
+        ar & balance_by_cost;
         ar & chunk_size;
+        ar & payload_bytes;
+        ar & slow_ranks;
+        ar & slowdown;
+        ar & slow_sleep;
+        ar & share_batch;
+        ar & share_batch_window;
+        ar & steal_policy;
         ar & polling_interval;
         ar & verbose;
         ar & debug;
+        ar & trace_buffer_size;
+        ar & csr_file;
+        ar & queue_memory_cap;
+        ar & reduce;
+        ar & max_nodes;
     }
 
     node::tree_type type;
@@ -126,10 +289,28 @@ struct params
     int non_leaf_bf;
     double shift_depth;
     int compute_granularity;
+    node::cost_distribution cost_dist;
+    double cost_heavy_fraction;
+    double cost_heavy_factor;
+    double cost_pareto_alpha;
+    double cost_pareto_scale;   // x_m relative to the mean, see node::pareto_scale
+    bool balance_by_cost;
     std::size_t chunk_size;
+    std::size_t payload_bytes;
+    std::vector<std::size_t> slow_ranks;
+    double slowdown;
+    int slow_sleep;
+    std::size_t share_batch;
+    int share_batch_window;
+    steal_policy_type steal_policy;
     int polling_interval;
     int verbose;
     int debug;
+    std::size_t trace_buffer_size;
+    std::string csr_file;
+    std::size_t queue_memory_cap;
+    bool reduce;
+    std::size_t max_nodes;          // truncate the search after about this many nodes, 0: complete search
 };
 
 inline boost::program_options::options_description uts_params_desc()
@@ -183,11 +364,86 @@ inline boost::program_options::options_description uts_params_desc()
           , boost::program_options::value<int>()->default_value(1)
           , "compute granularity: number of rng_spawns per node"
         )
+        (
+            "cost-distribution"
+          , boost::program_options::value<node::cost_distribution>()->default_value(node::FIXED_COST)
+          , "distribution of the per node compute cost: at least one rng_spawn per child, the spawns above that follow the distribution, so that the mean is exactly the compute granularity (0: FIXED, 1: UNIFORM, 2: BIMODAL, 3: PARETO)"
+        )
+        (
+            "cost-heavy-fraction"
+          , boost::program_options::value<double>()->default_value(0.1)
+          , "BIMODAL: fraction of expensive nodes"
+        )
+        (
+            "cost-heavy-factor"
+          , boost::program_options::value<double>()->default_value(10.0)
+          , "BIMODAL: cost above one rng_spawn of expensive nodes relative to cheap nodes"
+        )
+        (
+            "cost-pareto-alpha"
+          , boost::program_options::value<double>()->default_value(1.5)
+          , "PARETO: shape parameter, must be greater than 1, smaller values give heavier tails"
+        )
+        (
+            "balance-by-cost"
+          , boost::program_options::value<int>()->default_value(0)
+          , "nonzero to share work by estimated cost instead of node count"
+        )
         (
             "chunk-size"
           , boost::program_options::value<std::size_t>()->default_value(20)
           , "chunksize for work sharing and work stealing"
         )
+        (
+            "node-payload-bytes"
+          , boost::program_options::value<std::size_t>()->default_value(0)
+          , "size of the payload attached to every node, copied into each child and shipped with steals and shares"
+        )
+        (
+            "csr-file"
+          , boost::program_options::value<std::string>()->default_value("")
+          , "traverse the explicit tree stored in this CSR file (see uts_csr_gen) instead of generating it"
+        )
+        (
+            "queue-memory-cap"
+          , boost::program_options::value<std::size_t>()->default_value(0)
+          , "bytes a stealstack queue may hold before nodes are expanded depth first, 0: unbounded"
+        )
+        (
+            "reduce"
+          , boost::program_options::value<int>()->default_value(0)
+          , "nonzero to compute per depth node and leaf histograms and a checksum of the tree"
+        )
+        (
+            "slow-ranks"
+          , boost::program_options::value<std::string>()->default_value("")
+          , "comma separated list of stealstacks to slow down, e.g. 0,4-7"
+        )
+        (
+            "slowdown"
+          , boost::program_options::value<double>()->default_value(1.0)
+          , "factor by which the compute cost of every node is multiplied on slow stealstacks"
+        )
+        (
+            "slow-sleep"
+          , boost::program_options::value<int>()->default_value(0)
+          , "microseconds slow stealstacks sleep after every chunk"
+        )
+        (
+            "share-batch"
+          , boost::program_options::value<std::size_t>()->default_value(1)
+          , "worksharing: number of chunks (or acknowledgements) sent to one destination in a single message"
+        )
+        (
+            "share-batch-window"
+          , boost::program_options::value<int>()->default_value(100)
+          , "worksharing: microseconds after which a partially filled batch is sent anyway"
+        )
+        (
+            "steal-policy"
+          , boost::program_options::value<int>()->default_value(0)
+          , "victim selection (0: round robin, 1: weighted by the load piggybacked on steal replies and shares)"
+        )
         (
             "interval"
           , boost::program_options::value<int>()->default_value(0)
@@ -206,13 +462,29 @@ inline boost::program_options::options_description uts_params_desc()
         (
             "debug"
           , boost::program_options::value<int>()->default_value(0)
-          , "debug"
+          , "debug bit field (1: print root node, 2: record steal trace)"
+        )
+        (
+            "trace-buffer-size"
+          , boost::program_options::value<std::size_t>()->default_value(65536)
+          , "number of trace events kept per worker thread and stealstack"
+        )
+        (
+            "sample-interval"
+          , boost::program_options::value<int>()->default_value(0)
+          , "milliseconds between samples of the throughput timeline, 0: no timeline"
+        )
+        (
+            "trace-file"
+          , boost::program_options::value<std::string>()->default_value("uts_trace.json")
+          , "file the steal trace is written to (Chrome trace format)"
         )
         ;
 
     return desc;
 }
 
+#if !defined(UTS_NO_HPX)
 inline std::pair<std::size_t, std::vector<hpx::util::remote_locality_result> >
 distribute_stealstacks(std::vector<hpx::id_type> localities, float overcommit_factor, hpx::components::component_type type);
 
@@ -311,11 +583,8 @@ distribute_stealstacks(std::vector<hpx::id_type> localities, float overcommit_fa
 
 template <typename StealStack>
 inline std::vector<hpx::id_type> create_stealstacks(
-    boost::program_options::variables_map & vm, const char * name)
+    params const & p, float overcommit_factor)
 {
-    float overcommit_factor = vm["overcommit-factor"].as<float>();
-
-
     hpx::components::component_type type =
         hpx::components::get_component_type<StealStack>();
     
@@ -329,10 +598,6 @@ inline std::vector<hpx::id_type> create_stealstacks(
         async_result = hpx::async<distribute_stealstacks_action>(
             id, boost::move(localities), overcommit_factor, type);
 
-    params p(vm);
-
-    p.print(name);
-
     std::vector<hpx::id_type> stealstacks;
 
     std::vector<hpx::future<void> > init_futures;
@@ -376,5 +641,17 @@ inline std::vector<hpx::id_type> create_stealstacks(
     return stealstacks;
 }
 
+template <typename StealStack>
+inline std::vector<hpx::id_type> create_stealstacks(
+    boost::program_options::variables_map & vm, const char * name)
+{
+    params p(vm);
+
+    p.print(name);
+
+    return create_stealstacks<StealStack>(p, vm["overcommit-factor"].as<float>());
+}
+#endif
+
 
 #endif
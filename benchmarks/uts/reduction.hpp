@@ -0,0 +1,154 @@
+//  Copyright (c) 2026 The STE||AR Group
+//
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef BENCHMARKS_UTS_REDUCTION_HPP
+#define BENCHMARKS_UTS_REDUCTION_HPP
+
+#include <benchmarks/uts/uts.hpp>
+
+#include <hpx/hpx.hpp>
+#include <hpx/include/iostreams.hpp>
+
+#include <boost/cstdint.hpp>
+#include <boost/foreach.hpp>
+
+#include <algorithm>
+#include <iomanip>
+#include <vector>
+
+// Per depth node and leaf histograms and a checksum over all nodes. The
+// checksum is the sum of a hash of every node, it doesn't depend on the
+// order in which the nodes are visited, so runs with different load
+// balancing settings have to produce the same value.
+struct tree_summary
+{
+    tree_summary()
+      : checksum(0)
+    {}
+
+    static boost::uint64_t hash(node const & n)
+    {
+        // FNV-1a over the state, finished with the splitmix64 mixer
+        boost::uint64_t h = 14695981039346656037ULL;
+        unsigned char const * bytes = reinterpret_cast<unsigned char const *>(&n.state);
+        for(std::size_t i = 0; i < sizeof(n.state); ++i)
+        {
+            h ^= bytes[i];
+            h *= 1099511628211ULL;
+        }
+        h ^= n.height;
+        h = (h ^ (h >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        h = (h ^ (h >> 27)) * 0x94d049bb133111ebULL;
+        return h ^ (h >> 31);
+    }
+
+    void add(node const & n, int num_children)
+    {
+        if(n.height >= depth_hist.size())
+        {
+            depth_hist.resize(n.height + 1, 0);
+            leaf_hist.resize(n.height + 1, 0);
+        }
+        ++depth_hist[n.height];
+        if(num_children == 0) ++leaf_hist[n.height];
+        checksum += hash(n);
+    }
+
+    tree_summary & operator+=(tree_summary const & rhs)
+    {
+        if(rhs.depth_hist.size() > depth_hist.size())
+        {
+            depth_hist.resize(rhs.depth_hist.size(), 0);
+            leaf_hist.resize(rhs.leaf_hist.size(), 0);
+        }
+        for(std::size_t i = 0; i < rhs.depth_hist.size(); ++i)
+        {
+            depth_hist[i] += rhs.depth_hist[i];
+            leaf_hist[i] += rhs.leaf_hist[i];
+        }
+        checksum += rhs.checksum;
+        return *this;
+    }
+
+    template <typename Archive>
+    void serialize(Archive & ar, unsigned)
+    {
+        ar & depth_hist;
+        ar & leaf_hist;
+        ar & checksum;
+    }
+
+    std::vector<std::size_t> depth_hist;
+    std::vector<std::size_t> leaf_hist;
+    boost::uint64_t checksum;
+};
+
+// One tree_summary per OS worker thread. add() doesn't suspend the calling
+// HPX thread, so no two writers ever touch the same summary concurrently and
+// no locking is necessary.
+struct combinable_summary
+{
+    void init(std::size_t num_threads)
+    {
+        summaries.resize(num_threads);
+    }
+
+    void add(node const & n, int num_children)
+    {
+        std::size_t thread_num = hpx::get_worker_thread_num();
+        if(thread_num >= summaries.size()) return;
+
+        summaries[thread_num].add(n, num_children);
+    }
+
+    tree_summary combine() const
+    {
+        tree_summary res;
+        BOOST_FOREACH(tree_summary const & s, summaries)
+        {
+            res += s;
+        }
+        return res;
+    }
+
+    std::vector<tree_summary> summaries;
+};
+
+template <typename StealStack>
+tree_summary reduce_summaries(std::vector<hpx::id_type> const & stealstacks)
+{
+    std::vector<hpx::future<tree_summary> > summary_futures;
+    summary_futures.reserve(stealstacks.size());
+    BOOST_FOREACH(hpx::id_type const & id, stealstacks)
+    {
+        summary_futures.push_back(
+            hpx::async<typename StealStack::get_summary_action>(id)
+        );
+    }
+    hpx::wait_all(summary_futures);
+
+    tree_summary res;
+    BOOST_FOREACH(hpx::future<tree_summary> & f, summary_futures)
+    {
+        res += f.get();
+    }
+    return res;
+}
+
+inline void show_summary(tree_summary const & summary)
+{
+    hpx::cout << "Depth histogram (depth: nodes, leaves)\n";
+    for(std::size_t i = 0; i < summary.depth_hist.size(); ++i)
+    {
+        hpx::cout << "  " << i << ": " << summary.depth_hist[i]
+            << ", " << summary.leaf_hist[i] << "\n";
+    }
+    hpx::cout
+        << "Checksum = 0x" << std::hex << std::setw(16) << std::setfill('0')
+            << summary.checksum << std::dec << std::setfill(' ') << "\n"
+        << "\n" << hpx::flush;
+}
+
+#endif
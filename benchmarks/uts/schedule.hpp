@@ -0,0 +1,187 @@
+//  Copyright (c) 2026 The STE||AR Group
+//
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef BENCHMARKS_UTS_SCHEDULE_HPP
+#define BENCHMARKS_UTS_SCHEDULE_HPP
+
+#include <boost/cstdint.hpp>
+#include <boost/foreach.hpp>
+
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// Steal schedules are stored in a binary file in host byte order:
+//
+//   char magic[8]
+//   boost::uint64_t num_stealstacks
+//   for every stealstack:
+//     boost::uint64_t num_steals
+//     boost::uint64_t steals[num_steals]
+//
+// Every steal attempt of a thief is packed into one word, see steal_schedule.
+#define UTS_SCHEDULE_MAGIC "UTSSCH01"
+
+// The steal decisions of one stealstack. In record mode every steal attempt
+// is appended, in replay mode the thief asks the recorded victims for the
+// recorded number of chunks, in the recorded order. Once the schedule is
+// exhausted, the thief falls back to its steal policy.
+struct steal_schedule
+{
+    enum mode_type
+    {
+        OFF    = 0,
+        RECORD = 1,
+        REPLAY = 2
+    };
+
+    steal_schedule()
+      : mode(OFF)
+      , next(0)
+      , diverged(0)
+    {}
+
+    // victim in the low 32 bits, chunks in the next 24, outcome in the top 8
+    static boost::uint64_t pack(std::size_t victim, std::size_t chunks, int outcome)
+    {
+        if(chunks > 0xffffff) chunks = 0xffffff;
+        return boost::uint64_t(victim & 0xffffffff)
+            | (boost::uint64_t(chunks) << 32)
+            | (boost::uint64_t(outcome & 0xff) << 56);
+    }
+
+    static std::size_t victim(boost::uint64_t steal)
+    {
+        return static_cast<std::size_t>(steal & 0xffffffff);
+    }
+
+    static std::size_t chunks(boost::uint64_t steal)
+    {
+        return static_cast<std::size_t>((steal >> 32) & 0xffffff);
+    }
+
+    static int outcome(boost::uint64_t steal)
+    {
+        return static_cast<int>(steal >> 56);
+    }
+
+    void record()
+    {
+        mode = RECORD;
+        steals.clear();
+        next = 0;
+        diverged = 0;
+    }
+
+    void replay(std::vector<boost::uint64_t> const & s)
+    {
+        mode = REPLAY;
+        steals = s;
+        next = 0;
+        diverged = 0;
+    }
+
+    bool replaying() const
+    {
+        return mode == REPLAY && next < steals.size();
+    }
+
+    // the next recorded steal attempt, only valid if replaying()
+    boost::uint64_t peek() const
+    {
+        return steals[next];
+    }
+
+    // called after every steal attempt with what actually happened
+    void add(std::size_t victim, std::size_t chunks, int outcome)
+    {
+        boost::uint64_t steal = pack(victim, chunks, outcome);
+        if(mode == RECORD)
+        {
+            steals.push_back(steal);
+        }
+        else if(replaying())
+        {
+            if(steals[next] != steal) ++diverged;
+            ++next;
+        }
+    }
+
+    mode_type mode;
+    std::vector<boost::uint64_t> steals;
+    std::size_t next;
+    std::size_t diverged;   // replayed steals with a different outcome
+};
+
+inline void write_schedule(std::string const & filename,
+    std::vector<std::vector<boost::uint64_t> > const & schedules)
+{
+    std::ofstream os(filename.c_str(), std::ios::binary);
+    if(!os)
+    {
+        throw std::logic_error("write_schedule(): could not open " + filename);
+    }
+
+    os.write(UTS_SCHEDULE_MAGIC, 8);
+    boost::uint64_t num = schedules.size();
+    os.write(reinterpret_cast<char const *>(&num), sizeof(num));
+    BOOST_FOREACH(std::vector<boost::uint64_t> const & steals, schedules)
+    {
+        num = steals.size();
+        os.write(reinterpret_cast<char const *>(&num), sizeof(num));
+        if(!steals.empty())
+        {
+            os.write(reinterpret_cast<char const *>(&steals[0]),
+                steals.size() * sizeof(boost::uint64_t));
+        }
+    }
+
+    if(!os)
+    {
+        throw std::logic_error("write_schedule(): could not write " + filename);
+    }
+}
+
+inline std::vector<std::vector<boost::uint64_t> > read_schedule(std::string const & filename)
+{
+    std::ifstream is(filename.c_str(), std::ios::binary);
+    if(!is)
+    {
+        throw std::logic_error("read_schedule(): could not open " + filename);
+    }
+
+    char magic[8];
+    is.read(magic, 8);
+    if(!is || std::memcmp(magic, UTS_SCHEDULE_MAGIC, 8) != 0)
+    {
+        throw std::logic_error("read_schedule(): " + filename + " is not a steal schedule");
+    }
+
+    boost::uint64_t num = 0;
+    is.read(reinterpret_cast<char *>(&num), sizeof(num));
+
+    std::vector<std::vector<boost::uint64_t> > schedules(is ? num : 0);
+    BOOST_FOREACH(std::vector<boost::uint64_t> & steals, schedules)
+    {
+        is.read(reinterpret_cast<char *>(&num), sizeof(num));
+        if(!is) break;
+        steals.resize(num);
+        if(num > 0)
+        {
+            is.read(reinterpret_cast<char *>(&steals[0]), num * sizeof(boost::uint64_t));
+        }
+    }
+
+    if(!is)
+    {
+        throw std::logic_error("read_schedule(): " + filename + " is truncated");
+    }
+
+    return schedules;
+}
+
+#endif
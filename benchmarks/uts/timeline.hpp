@@ -0,0 +1,124 @@
+//  Copyright (c) 2026 The STE||AR Group
+//
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef BENCHMARKS_UTS_TIMELINE_HPP
+#define BENCHMARKS_UTS_TIMELINE_HPP
+
+#include <hpx/hpx.hpp>
+#include <hpx/include/iostreams.hpp>
+#include <hpx/util/high_resolution_timer.hpp>
+
+#include <boost/foreach.hpp>
+
+#include <vector>
+
+// progress of one stealstack, read from atomic counters without locking
+struct progress
+{
+    progress()
+      : nodes(0)
+      , active(false)
+    {}
+
+    template <typename Archive>
+    void serialize(Archive & ar, unsigned)
+    {
+        ar & nodes;
+        ar & active;
+    }
+
+    std::size_t nodes;      // nodes taken from the queue so far
+    bool active;            // has work, as opposed to looking for work
+};
+
+struct timeline_sample
+{
+    double time;            // seconds since the start of the search
+    std::size_t nodes;
+    std::size_t active;     // number of active stealstacks
+};
+
+template <typename Future>
+bool all_ready(std::vector<Future> const & futures)
+{
+    BOOST_FOREACH(Future const & f, futures)
+    {
+        if(!f.is_ready()) return false;
+    }
+    return true;
+}
+
+// Poll the progress of all stealstacks every interval_ms milliseconds
+// until the searches are done. The last sample is taken after the
+// searches finished.
+template <typename StealStack, typename Future>
+std::vector<timeline_sample> sample_timeline(
+    std::vector<hpx::id_type> const & stealstacks
+  , std::vector<Future> const & searches
+  , int interval_ms)
+{
+    std::vector<timeline_sample> samples;
+    hpx::util::high_resolution_timer t;
+
+    while(true)
+    {
+        bool done = all_ready(searches);
+
+        std::vector<hpx::future<progress> > progress_futures;
+        progress_futures.reserve(stealstacks.size());
+        BOOST_FOREACH(hpx::id_type const & id, stealstacks)
+        {
+            progress_futures.push_back(
+                hpx::async<typename StealStack::get_progress_action>(id)
+            );
+        }
+        hpx::wait_all(progress_futures);
+
+        timeline_sample sample;
+        sample.time = t.elapsed();
+        sample.nodes = 0;
+        sample.active = 0;
+        BOOST_FOREACH(hpx::future<progress> & f, progress_futures)
+        {
+            progress p = f.get();
+            sample.nodes += p.nodes;
+            if(p.active) ++sample.active;
+        }
+        samples.push_back(sample);
+
+        if(done) break;
+
+        hpx::this_thread::suspend(boost::posix_time::milliseconds(interval_ms));
+    }
+
+    return samples;
+}
+
+// Print the timeline, the throughput is computed between consecutive
+// samples, so ramp-up, steady state and drain of the search can be told
+// apart.
+inline void show_timeline(std::vector<timeline_sample> const & samples, int interval_ms)
+{
+    hpx::cout
+        << "Timeline (sample interval " << interval_ms << " ms)\n"
+        << "# time nodes nodes/sec active\n";
+
+    double last_time = 0.0;
+    std::size_t last_nodes = 0;
+    BOOST_FOREACH(timeline_sample const & sample, samples)
+    {
+        double dt = sample.time - last_time;
+        hpx::cout
+            << sample.time << " "
+            << sample.nodes << " "
+            << static_cast<long long>(dt > 0.0 ? (sample.nodes - last_nodes) / dt : 0.0) << " "
+            << sample.active << "\n";
+        last_time = sample.time;
+        last_nodes = sample.nodes;
+    }
+    hpx::cout << "\n" << hpx::flush;
+}
+
+#endif
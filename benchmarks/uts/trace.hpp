@@ -0,0 +1,353 @@
+//  Copyright (c) 2026 The STE||AR Group
+//
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef BENCHMARKS_UTS_TRACE_HPP
+#define BENCHMARKS_UTS_TRACE_HPP
+
+#include <hpx/hpx.hpp>
+#include <hpx/include/iostreams.hpp>
+#include <hpx/util/high_resolution_clock.hpp>
+
+#include <boost/cstdint.hpp>
+#include <boost/foreach.hpp>
+
+#include <algorithm>
+#include <fstream>
+#include <string>
+#include <vector>
+
+// bit in params::debug which switches on the steal event trace
+#define UTS_DEBUG_TRACE 2
+
+struct trace_event
+{
+    enum kind_type
+    {
+        STEAL    = 0,   // steal attempt issued by a thief
+        SHARE    = 1,   // chunks released to another stealstack
+        TRANSFER = 2,   // chunks received from another stealstack
+        IDLE     = 3,   // period without local work
+        NKINDS   = 4
+    };
+
+    enum outcome_type
+    {
+        SUCCESS     = 0,
+        VICTIM_BUSY = 1,    // victim had work, but not enough to give some away
+        VICTIM_IDLE = 2     // victim had no work at all
+    };
+
+    static const char * kind_str(int kind)
+    {
+        switch (kind)
+        {
+            case STEAL:
+                return "steal";
+            case SHARE:
+                return "share";
+            case TRANSFER:
+                return "transfer";
+            case IDLE:
+                return "idle";
+            default:
+                return "unknown";
+        }
+    }
+
+    static const char * outcome_str(int outcome)
+    {
+        switch (outcome)
+        {
+            case SUCCESS:
+                return "success";
+            case VICTIM_BUSY:
+                return "victim busy";
+            case VICTIM_IDLE:
+                return "victim idle";
+            default:
+                return "unknown";
+        }
+    }
+
+    template <typename Archive>
+    void serialize(Archive & ar, unsigned)
+    {
+        ar & begin;
+        ar & end;
+        ar & locality;
+        ar & rank;
+        ar & peer;
+        ar & chunks;
+        ar & nodes;
+        ar & kind;
+        ar & outcome;
+    }
+
+    boost::uint64_t begin;      // nanoseconds, local clock of the locality
+    boost::uint64_t end;
+    boost::uint32_t locality;
+    boost::uint32_t rank;
+    boost::uint32_t peer;
+    boost::uint32_t chunks;
+    boost::uint32_t nodes;
+    boost::uint8_t kind;
+    boost::uint8_t outcome;
+};
+
+// The events recorded by one stealstack, and the number of events lost
+// because its ring buffers wrapped around
+struct trace_data
+{
+    trace_data()
+      : dropped(0)
+    {}
+
+    template <typename Archive>
+    void serialize(Archive & ar, unsigned)
+    {
+        ar & events;
+        ar & dropped;
+    }
+
+    std::vector<trace_event> events;
+    boost::uint64_t dropped;
+};
+
+// Fixed size ring buffer of trace events. The storage is allocated once by
+// reserve(), record() never allocates and overwrites the oldest events once
+// the buffer is full.
+struct trace_ring_buffer
+{
+    trace_ring_buffer()
+      : head(0)
+    {}
+
+    void reserve(std::size_t capacity)
+    {
+        events.resize(capacity);
+        head = 0;
+    }
+
+    void record(trace_event const & e)
+    {
+        if(events.empty()) return;
+        events[head % events.size()] = e;
+        ++head;
+    }
+
+    std::size_t dropped() const
+    {
+        return head > events.size() ? head - events.size() : 0;
+    }
+
+    // append the recorded events in chronological order
+    void copy_to(std::vector<trace_event> & out) const
+    {
+        if(head <= events.size())
+        {
+            out.insert(out.end(), events.begin(), events.begin() + head);
+            return;
+        }
+
+        std::size_t first = head % events.size();
+        out.insert(out.end(), events.begin() + first, events.end());
+        out.insert(out.end(), events.begin(), events.begin() + first);
+    }
+
+    std::vector<trace_event> events;
+    boost::uint64_t head;
+};
+
+// One ring buffer per OS worker thread. Recording does not suspend the
+// calling HPX thread, so no two writers ever touch the same buffer
+// concurrently and no locking is necessary.
+struct trace_buffers
+{
+    trace_buffers()
+      : enabled(false)
+      , rank(0)
+    {}
+
+    void init(std::size_t r, std::size_t num_threads, std::size_t capacity)
+    {
+        enabled = true;
+        rank = r;
+        buffers.resize(num_threads);
+        BOOST_FOREACH(trace_ring_buffer & buffer, buffers)
+        {
+            buffer.reserve(capacity);
+        }
+    }
+
+    static boost::uint64_t now()
+    {
+        return hpx::util::high_resolution_clock::now();
+    }
+
+    void record(
+        trace_event::kind_type kind
+      , boost::uint64_t begin
+      , boost::uint64_t end
+      , std::size_t peer
+      , std::size_t chunks = 0
+      , std::size_t nodes = 0
+      , trace_event::outcome_type outcome = trace_event::SUCCESS)
+    {
+        if(!enabled) return;
+
+        std::size_t thread_num = hpx::get_worker_thread_num();
+        if(thread_num >= buffers.size()) return;
+
+        trace_event e;
+        e.begin = begin;
+        e.end = end;
+        e.locality = 0;
+        e.rank = static_cast<boost::uint32_t>(rank);
+        e.peer = static_cast<boost::uint32_t>(peer);
+        e.chunks = static_cast<boost::uint32_t>(chunks);
+        e.nodes = static_cast<boost::uint32_t>(nodes);
+        e.kind = static_cast<boost::uint8_t>(kind);
+        e.outcome = static_cast<boost::uint8_t>(outcome);
+
+        buffers[thread_num].record(e);
+    }
+
+    trace_data get() const
+    {
+        trace_data res;
+        if(!enabled) return res;
+
+        boost::uint32_t locality = hpx::get_locality_id();
+        BOOST_FOREACH(trace_ring_buffer const & buffer, buffers)
+        {
+            buffer.copy_to(res.events);
+        }
+        BOOST_FOREACH(trace_event & e, res.events)
+        {
+            e.locality = locality;
+        }
+        res.dropped = dropped();
+        return res;
+    }
+
+    std::size_t dropped() const
+    {
+        std::size_t res = 0;
+        BOOST_FOREACH(trace_ring_buffer const & buffer, buffers)
+        {
+            res += buffer.dropped();
+        }
+        return res;
+    }
+
+    bool enabled;
+    std::size_t rank;
+    std::vector<trace_ring_buffer> buffers;
+};
+
+// Write the events in the Chrome trace event format, which can be loaded by
+// chrome://tracing and Perfetto. Each locality shows up as a process, each
+// stealstack as a thread. Timestamps of different localities come from
+// different clocks and are only comparable within one locality. The number
+// of events lost to wrapped ring buffers goes into the trace metadata.
+inline void write_chrome_trace(
+    std::string const & filename, std::vector<trace_event> const & events,
+    boost::uint64_t dropped)
+{
+    std::ofstream os(filename.c_str());
+    if(!os)
+    {
+        hpx::cout << "*** could not open trace file " << filename << "\n" << hpx::flush;
+        return;
+    }
+
+    boost::uint64_t t0 = 0;
+    if(!events.empty())
+    {
+        t0 = events[0].begin;
+        BOOST_FOREACH(trace_event const & e, events)
+        {
+            t0 = (std::min)(t0, e.begin);
+        }
+    }
+
+    std::vector<std::pair<boost::uint32_t, boost::uint32_t> > threads;
+    threads.reserve(events.size());
+    BOOST_FOREACH(trace_event const & e, events)
+    {
+        threads.push_back(std::make_pair(e.locality, e.rank));
+    }
+    std::sort(threads.begin(), threads.end());
+    threads.erase(std::unique(threads.begin(), threads.end()), threads.end());
+
+    os << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n";
+
+    bool first = true;
+    typedef std::pair<boost::uint32_t, boost::uint32_t> thread_type;
+    BOOST_FOREACH(thread_type const & t, threads)
+    {
+        if(!first) os << ",\n";
+        first = false;
+        os << "{\"name\":\"thread_name\",\"ph\":\"M\""
+           << ",\"pid\":" << t.first << ",\"tid\":" << t.second
+           << ",\"args\":{\"name\":\"stealstack " << t.second << "\"}}";
+    }
+
+    os.precision(3);
+    os.setf(std::ios::fixed, std::ios::floatfield);
+    BOOST_FOREACH(trace_event const & e, events)
+    {
+        if(!first) os << ",\n";
+        first = false;
+        os << "{\"name\":\"" << trace_event::kind_str(e.kind) << "\""
+           << ",\"cat\":\"uts\",\"ph\":\"X\""
+           << ",\"ts\":" << (e.begin - t0) / 1000.0
+           << ",\"dur\":" << (e.end - e.begin) / 1000.0
+           << ",\"pid\":" << e.locality << ",\"tid\":" << e.rank
+           << ",\"args\":{"
+           << "\"peer\":" << e.peer
+           << ",\"chunks\":" << e.chunks
+           << ",\"nodes\":" << e.nodes
+           << ",\"outcome\":\"" << trace_event::outcome_str(e.outcome) << "\""
+           << "}}";
+    }
+
+    os << "\n],\"otherData\":{\"dropped_events\":" << dropped << "}}\n";
+}
+
+template <typename StealStack>
+void write_trace(std::vector<hpx::id_type> const & stealstacks, std::string const & filename)
+{
+    std::vector<hpx::future<trace_data> > trace_futures;
+    trace_futures.reserve(stealstacks.size());
+    BOOST_FOREACH(hpx::id_type const & id, stealstacks)
+    {
+        trace_futures.push_back(
+            hpx::async<typename StealStack::get_trace_action>(id)
+        );
+    }
+    hpx::wait_all(trace_futures);
+
+    std::vector<trace_event> events;
+    boost::uint64_t dropped = 0;
+    BOOST_FOREACH(hpx::future<trace_data> & f, trace_futures)
+    {
+        trace_data data = f.get();
+        events.insert(events.end(), data.events.begin(), data.events.end());
+        dropped += data.dropped;
+    }
+
+    write_chrome_trace(filename, events, dropped);
+
+    hpx::cout << "Wrote " << events.size() << " trace events to " << filename << "\n";
+    if(dropped > 0)
+    {
+        hpx::cout << "*** " << dropped << " older trace events were dropped, "
+                  << "the trace is incomplete (raise --trace-buffer-size)\n";
+    }
+    hpx::cout << hpx::flush;
+}
+
+#endif
@@ -9,20 +9,49 @@
 
 #include <benchmarks/uts/rng/rng.h>
 
+// UTS_NO_HPX allows to use the tree definition without the HPX runtime, for
+// the shared memory baselines
+#if defined(UTS_NO_HPX)
+#include <boost/foreach.hpp>
+#include <boost/shared_ptr.hpp>
+
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#define UTS_COUT std::cout
+#define UTS_FLUSH std::flush
+#else
 #include <hpx/hpx_init.hpp>
 #include <hpx/hpx.hpp>
 #include <hpx/include/iostreams.hpp>
 #include <hpx/components/distributing_factory/distributing_factory.hpp>
 
+#define UTS_COUT hpx::cout
+#define UTS_FLUSH hpx::flush
+#endif
+
+#include <boost/cstdint.hpp>
+#include <boost/static_assert.hpp>
+
+#include <algorithm>
 #include <cmath>
+#include <cstring>
+#include <numeric>
+
+#if !defined(BOOST_WINDOWS)
+#include <sys/resource.h>
+#endif
 
 #define MAX_NUM_CHILDREN    100  // cap on children (BIN root is exempt)
+#define MAX_COST_FACTOR     1000.0  // cap on the cost of a node, in multiples of the mean
 
 // Interpret 32 bit positive integer as value on [0,1)
 inline double rng_toProb(int n) 
 {
   if (n < 0) {
-      hpx::cout << "*** toProb: rand n = " << n << " out of range\n" << hpx::flush;
+      UTS_COUT << "*** toProb: rand n = " << n << " out of range\n" << UTS_FLUSH;
   }
   return ((n<0)? 0.0 : ((double) n)/2147483648.0);
 }
@@ -77,6 +106,30 @@ struct node
         }
     }
 
+    enum cost_distribution {
+        FIXED_COST = 0,
+        UNIFORM_COST,
+        BIMODAL_COST,
+        PARETO_COST
+    };
+
+    static std::string cost_distribution_str(cost_distribution type)
+    {
+        switch (type)
+        {
+            case FIXED_COST:
+                return "Fixed";
+            case UNIFORM_COST:
+                return "Uniform";
+            case BIMODAL_COST:
+                return "Bimodal";
+            case PARETO_COST:
+                return "Pareto";
+            default:
+                return "Unkown";
+        }
+    }
+
     int type;
     std::size_t height;
     int num_children;
@@ -102,8 +155,112 @@ struct node
 
         if(p.debug & 1)
         {
-            hpx::cout << "root node of type " << p.type 
-                << " at " << std::hex << this << std::dec << "\n" << hpx::flush;
+            UTS_COUT << "root node of type " << p.type 
+                << " at " << std::hex << this << std::dec << "\n" << UTS_FLUSH;
+        }
+    }
+
+    // Nodes of explicit trees (see csr.hpp) carry their index into the CSR
+    // in place of the RNG state.
+    boost::uint64_t csr_index() const
+    {
+        BOOST_STATIC_ASSERT(sizeof(state_t) >= sizeof(boost::uint64_t));
+        boost::uint64_t i;
+        std::memcpy(&i, &state, sizeof(i));
+        return i;
+    }
+
+    void set_csr_index(boost::uint64_t i)
+    {
+        std::memset(&state, 0, sizeof(state));
+        std::memcpy(&state, &i, sizeof(i));
+    }
+
+    // random number on [0, 2^31) derived from all bytes of the state (FNV-1a),
+    // rng_rand only looks at the last four bytes. Different salts give
+    // independent numbers for the same node.
+    int cost_rand(boost::uint32_t salt = 0) const
+    {
+        boost::uint32_t h = 2166136261u;
+        if(salt != 0)
+        {
+            h ^= salt;
+            h *= 16777619u;
+        }
+        unsigned char const * bytes = reinterpret_cast<unsigned char const *>(&state);
+        for(std::size_t i = 0; i < sizeof(state); ++i)
+        {
+            h ^= bytes[i];
+            h *= 16777619u;
+        }
+        return static_cast<int>(h & 0x7fffffff);
+    }
+
+    // x rounded down or up at random, so that the mean of the result is x
+    int round_stochastic(double x) const
+    {
+        double f = std::floor(x);
+        return static_cast<int>(f) + (rng_toProb(cost_rand(1)) < x - f ? 1 : 0);
+    }
+
+    // Scale x_m / mean of a Pareto distribution with shape alpha > 1 whose
+    // samples are capped at MAX_COST_FACTOR * mean, such that the mean of
+    // the capped samples is the requested one. Solves
+    //   r alpha / (alpha - 1) - r^alpha K^(1 - alpha) / (alpha - 1) = 1
+    // for r by bisection, the left side grows with r on (0, K].
+    static double pareto_scale(double alpha)
+    {
+        double lo = 0.0;
+        double hi = MAX_COST_FACTOR;
+        for(int i = 0; i < 100; ++i)
+        {
+            double r = (lo + hi) / 2;
+            double mean = (r * alpha
+                - std::pow(r, alpha) * std::pow(MAX_COST_FACTOR, 1.0 - alpha)) / (alpha - 1.0);
+            if(mean < 1.0) lo = r;
+            else hi = r;
+        }
+        return (lo + hi) / 2;
+    }
+
+    // Compute cost of this node: the number of rng_spawns done for every
+    // child. Every child needs at least one rng_spawn, the spawns above that
+    // follow the distribution with mean g - 1, and are rounded at random
+    // to keep that mean. The mean of every distribution is therefore exactly
+    // the compute granularity g.
+    template <typename Params>
+    int cost(Params const & p) const
+    {
+        int g = p.compute_granularity;
+        if(p.cost_dist == FIXED_COST || g <= 1) return g;
+
+        double extra = g - 1;
+        double u = rng_toProb(cost_rand());
+        switch (p.cost_dist)
+        {
+            // uniform on [1, 2g - 1]
+            case UNIFORM_COST:
+                return 1 + static_cast<int>(u * (2 * g - 1));
+            // the extra spawns are cost_heavy_factor times higher with
+            // probability cost_heavy_fraction
+            case BIMODAL_COST:
+                {
+                    double h = p.cost_heavy_factor;
+                    double f = p.cost_heavy_fraction;
+                    double light = extra / (1.0 - f + f * h);
+                    return 1 + round_stochastic(u < f ? h * light : light);
+                }
+            // the extra spawns are Pareto distributed with shape
+            // cost_pareto_alpha, capped at MAX_COST_FACTOR times their mean
+            case PARETO_COST:
+                {
+                    double alpha = p.cost_pareto_alpha;
+                    double x_m = p.cost_pareto_scale * extra;
+                    double c = x_m * std::pow(1.0 - u, -1.0 / alpha);
+                    return 1 + round_stochastic((std::min)(c, MAX_COST_FACTOR * extra));
+                }
+            default:
+                throw std::logic_error("node::cost(): Unknown cost distribution");
         }
     }
 
@@ -233,8 +390,8 @@ struct node
             int root_BF = (int)std::ceil(p.b_0);
             if(num > root_BF)
             {
-                hpx::cout << "*** Number of children of root truncated from "
-                    << num << " to " << root_BF << "\n" << hpx::flush;
+                UTS_COUT << "*** Number of children of root truncated from "
+                    << num << " to " << root_BF << "\n" << UTS_FLUSH;
                 num = root_BF;
             }
         }
@@ -242,8 +399,8 @@ struct node
         {
             if (num > MAX_NUM_CHILDREN)
             {
-                hpx::cout << "*** Number of children truncated from "
-                    << num << " to " << MAX_NUM_CHILDREN << "\n" << hpx::flush;
+                UTS_COUT << "*** Number of children truncated from "
+                    << num << " to " << MAX_NUM_CHILDREN << "\n" << UTS_FLUSH;
                 num = MAX_NUM_CHILDREN;
             }
         }
@@ -316,32 +473,183 @@ inline std::istream & operator>>(std::istream & is, node::geoshape & type)
     return is;
 }
 
+inline std::ostream & operator<<(std::ostream & os, node::cost_distribution type)
+{
+    os << node::cost_distribution_str(type);
+    return os;
+}
+
+inline std::istream & operator>>(std::istream & is, node::cost_distribution & type)
+{
+    int i;
+    is >> i;
+    switch (i)
+    {
+        case node::FIXED_COST:
+            type = node::FIXED_COST;
+            break;
+        case node::UNIFORM_COST:
+            type = node::UNIFORM_COST;
+            break;
+        case node::BIMODAL_COST:
+            type = node::BIMODAL_COST;
+            break;
+        case node::PARETO_COST:
+            type = node::PARETO_COST;
+            break;
+        default:
+            type = node::FIXED_COST;
+            break;
+    }
+    return is;
+}
+
+// A chunk of nodes. The optional fixed size payload of every node is kept in
+// one contiguous buffer next to the nodes, payload i belongs to work[i].
 struct stealstack_node
 {
     stealstack_node()
+      : cost(0)
     {}
 
-    stealstack_node(std::size_t size)
+    stealstack_node(std::size_t size, std::size_t payload_bytes = 0)
+      : cost(0)
     {
         work.reserve(size);
+        payload.reserve(size * payload_bytes);
     }
 
     template <typename Archive>
     void serialize(Archive & ar, unsigned)
     {
         ar & work;
+        ar & payload;
+        ar & cost;
     }
 
     void swap(stealstack_node& rhs)
     {
         std::swap(work, rhs.work);
+        std::swap(payload, rhs.payload);
+        std::swap(cost, rhs.cost);
+    }
+
+    void push_back(node const & n, char const * data, std::size_t payload_bytes,
+        std::size_t node_cost = 0)
+    {
+        work.push_back(n);
+        payload.insert(payload.end(), data, data + payload_bytes);
+        cost += node_cost;
+    }
+
+    // memory held by this chunk
+    std::size_t bytes() const
+    {
+        return sizeof(stealstack_node)
+            + work.capacity() * sizeof(node)
+            + payload.capacity();
+    }
+
+    char const * get_payload(std::size_t i, std::size_t payload_bytes) const
+    {
+        return payload_bytes == 0 ? 0 : &payload[i * payload_bytes];
+    }
+
+    void clear()
+    {
+        work.clear();
+        payload.clear();
+        cost = 0;
     }
 
     std::vector<node> work;
+    std::vector<char> payload;
+    std::size_t cost;       // estimated cost of all nodes, see node::cost
+};
+
+// Expand parent and append its children to children. Used by the searches
+// which don't run on stealstacks, Stats needs n_nodes, n_leaves and
+// max_tree_depth members.
+template <typename Params, typename Stats>
+void gen_children(node & parent, std::vector<node> & children, Params const & p, Stats & stat)
+{
+    std::size_t parent_height = parent.height;
+
+    stat.max_tree_depth = (std::max)(stat.max_tree_depth, parent_height);
+    ++stat.n_nodes;
+
+    int num_children = parent.get_num_children(p);
+    int child_type = parent.child_type(p);
+
+    parent.num_children = num_children;
+
+    if(num_children > 0)
+    {
+        int granularity = parent.cost(p);
+        for(int i = 0; i < num_children; ++i)
+        {
+            node child;
+            child.type = child_type;
+            child.height = parent_height + 1;
+            for(int j = 0; j < granularity; ++j)
+            {
+                rng_spawn(parent.state.state, child.state.state, i);
+            }
+
+            children.push_back(child);
+        }
+    }
+    else
+    {
+        ++stat.n_leaves;
+    }
+}
+
+// statistics of a single worker in the layout expected by show_stats, used
+// by the searches which don't run on stealstacks
+struct worker_stats
+{
+    enum states
+    {
+        WORK    = 0,
+        SEARCH  = 1,
+        IDLE    = 2,
+        OVH     = 3,
+        NSTATES = 4
+    };
+
+    worker_stats()
+      : n_nodes(0)
+      , n_leaves(0)
+      , n_release(0)
+      , n_acquire(0)
+      , n_steal(0)
+      , n_fail(0)
+      , max_stack_depth(0)
+      , max_tree_depth(0)
+    {
+        time[WORK] = 0.0;
+        time[SEARCH] = 0.0;
+        time[IDLE] = 0.0;
+        time[OVH] = 0.0;
+    }
+
+    std::size_t n_nodes;
+    std::size_t n_leaves;
+    std::size_t n_release;
+    std::size_t n_acquire;
+    std::size_t n_steal;
+    std::size_t n_fail;
+
+    std::size_t max_stack_depth;
+    std::size_t max_tree_depth;
+
+    double time[NSTATES];
 };
 
 template <typename Stats>
-void show_stats(double walltime, Stats const & stats, int verbose, std::size_t chunk_size, float overcommit_factor)
+void show_stats(double walltime, Stats const & stats, int verbose, std::size_t chunk_size, float overcommit_factor,
+    std::size_t num_threads)
 {
     std::size_t tnodes = 0, tleaves = 0, trel = 0, tacq = 0, tsteal = 0, tfail= 0;
     std::size_t mdepth = 0, mheight = 0;
@@ -380,15 +688,14 @@ void show_stats(double walltime, Stats const & stats, int verbose, std::size_t c
     }
 
     if (trel != tacq + tsteal) {
-        hpx::cout << "*** error! total released != total acquired + total stolen\n" << hpx::flush;
+        UTS_COUT << "*** error! total released != total acquired + total stolen\n" << UTS_FLUSH;
     }
 
     //uts_showStats(ss_get_num_threads(), chunkSize, walltime, tnodes, tleaves, mheight);
 
     // summarize execution info for machine consumption
     if (verbose == 0) {
-        std::size_t num_threads = hpx::get_num_worker_threads();
-        hpx::cout
+        UTS_COUT
             << num_threads << " "
             << walltime << " "
             << tnodes << " "
@@ -396,7 +703,7 @@ void show_stats(double walltime, Stats const & stats, int verbose, std::size_t c
             << static_cast<long long>((tnodes/walltime)/num_threads) << " "
             << chunk_size << " "
             << overcommit_factor << "\n"
-            << hpx::flush;
+            << UTS_FLUSH;
         /*
         printf("%4d %7.3f %9llu %7.0llu %7.0llu %d %d %.2f %d %d %1d %f %3d\n",
             nPes, walltime, nNodes, (long long)(nNodes/walltime), (long long)((nNodes/walltime)/nPes), chunkSize,
@@ -406,18 +713,26 @@ void show_stats(double walltime, Stats const & stats, int verbose, std::size_t c
 
     // summarize execution info for human consumption
     else {
-        hpx::cout
+        UTS_COUT
             << "Tree size = " << tnodes << ", "
             << "tree depth = " << mheight << ", "
             << "num leaves = " << tleaves
                 << " (" << tleaves/static_cast<float>(tnodes)*100.0f << "%)"
-            << "\n" << hpx::flush;
+            << "\n" << UTS_FLUSH;
 
-        hpx::cout
+        UTS_COUT
             << "Wallclock time = " << walltime << " sec\n"
             << "Performance = " << (tnodes / walltime) << " nodes/sec "
-            << "(" << (tnodes / walltime / hpx::get_num_worker_threads()) << " nodes/sec per PE)\n"
-            << "\n" << hpx::flush;
+            << "(" << (tnodes / walltime / num_threads) << " nodes/sec per PE)\n"
+            << "\n" << UTS_FLUSH;
+    }
+
+    if (verbose > 1) {
+        UTS_COUT
+            << "Total chunks released = " << trel << ", of which " << tacq
+                << " reacquired and " << tsteal << " stolen\n"
+            << "Failed steals = " << tfail << ", Max queue size = " << mdepth << "\n"
+            << "\n" << UTS_FLUSH;
     }
 
     /*
@@ -457,4 +772,191 @@ void show_stats(double walltime, Stats const & stats, int verbose, std::size_t c
     */
 }
 
+// Report how work drained away from stealstacks slowed down by --slow-ranks:
+// chunks given away and nodes explored by slow and regular stealstacks, and
+// the completion time tail caused by the stragglers. The completion time of
+// a stealstack is when it finished its last chunk, not when the search ended.
+template <typename Stats>
+void show_straggler_stats(Stats const & stats)
+{
+    std::size_t num_slow = 0, num_fast = 0;
+    std::size_t slow_nodes = 0, fast_nodes = 0;
+    std::size_t slow_release = 0, fast_release = 0;
+    std::vector<double> slow_times, fast_times;
+
+    BOOST_FOREACH(typename Stats::value_type const & stat, stats)
+    {
+        if(stat.slow)
+        {
+            ++num_slow;
+            slow_nodes += stat.n_nodes;
+            slow_release += stat.n_release;
+            slow_times.push_back(stat.completion_time);
+        }
+        else
+        {
+            ++num_fast;
+            fast_nodes += stat.n_nodes;
+            fast_release += stat.n_release;
+            fast_times.push_back(stat.completion_time);
+        }
+    }
+
+    if(num_slow == 0) return;
+
+    std::sort(slow_times.begin(), slow_times.end());
+    std::sort(fast_times.begin(), fast_times.end());
+
+    double slow_max = slow_times.back();
+    double fast_median = fast_times.empty() ? 0.0 : fast_times[fast_times.size() / 2];
+    double fast_max = fast_times.empty() ? 0.0 : fast_times.back();
+
+    UTS_COUT
+        << "Stragglers: " << num_slow << " of " << (num_slow + num_fast) << " stealstacks slowed down\n"
+        << "Chunks taken from slow stealstacks = " << slow_release
+            << " (" << static_cast<double>(slow_release) / num_slow << " per stealstack), "
+        << "from others = " << fast_release
+            << " (" << (num_fast ? static_cast<double>(fast_release) / num_fast : 0.0) << " per stealstack)\n"
+        << "Nodes explored by slow stealstacks = " << slow_nodes
+            << " (" << static_cast<double>(slow_nodes) / num_slow << " per stealstack), "
+        << "by others = " << fast_nodes
+            << " (" << (num_fast ? static_cast<double>(fast_nodes) / num_fast : 0.0) << " per stealstack)\n"
+        << "Completion time (end of the last chunk): slow max = " << slow_max << " sec, "
+        << "others median = " << fast_median << " sec, max = " << fast_max << " sec\n"
+        << "Completion time tail (slowest - median of others) = "
+            << ((std::max)(slow_max, fast_max) - fast_median) << " sec\n"
+        << "\n" << UTS_FLUSH;
+}
+
+#if !defined(UTS_NO_HPX)
+template <typename Stats>
+void show_stats(double walltime, Stats const & stats, int verbose, std::size_t chunk_size, float overcommit_factor)
+{
+    show_stats(walltime, stats, verbose, chunk_size, overcommit_factor,
+        hpx::get_num_worker_threads());
+}
+
+// peak resident set size of this process, 0 if unknown
+inline std::size_t peak_rss_bytes()
+{
+#if !defined(BOOST_WINDOWS)
+    rusage usage;
+    if(getrusage(RUSAGE_SELF, &usage) == 0)
+    {
+#if defined(__APPLE__)
+        return static_cast<std::size_t>(usage.ru_maxrss);
+#else
+        return static_cast<std::size_t>(usage.ru_maxrss) * 1024;
+#endif
+    }
+#endif
+    return 0;
+}
+
+HPX_PLAIN_ACTION(peak_rss_bytes);
+
+// Report the memory held by the stealstack queues next to the peak RSS of
+// the localities, and how many nodes were expanded depth first to stay
+// below --queue-memory-cap. Only called with verbose output or a cap set.
+template <typename Stats>
+void show_memory_stats(double walltime, Stats const & stats, std::size_t queue_memory_cap)
+{
+    std::size_t max_queue_bytes = 0, sum_queue_bytes = 0;
+    std::size_t nodes = 0, dfs_nodes = 0;
+    double avg_queue_bytes = 0.0;
+
+    BOOST_FOREACH(typename Stats::value_type const & stat, stats)
+    {
+        max_queue_bytes = (std::max)(max_queue_bytes, stat.max_queue_bytes);
+        sum_queue_bytes += stat.max_queue_bytes;
+        avg_queue_bytes += stat.avg_queue_bytes;
+        nodes += stat.n_nodes;
+        dfs_nodes += stat.n_dfs_nodes;
+    }
+    if(!stats.empty()) avg_queue_bytes /= stats.size();
+
+    std::vector<hpx::future<std::size_t> > rss_futures;
+    BOOST_FOREACH(hpx::id_type const & id, hpx::find_all_localities())
+    {
+        rss_futures.push_back(hpx::async<peak_rss_bytes_action>(id));
+    }
+    hpx::wait_all(rss_futures);
+    std::size_t max_rss = 0;
+    BOOST_FOREACH(hpx::future<std::size_t> & f, rss_futures)
+    {
+        max_rss = (std::max)(max_rss, f.get());
+    }
+
+    UTS_COUT
+        << "Queue memory: peak = " << max_queue_bytes << " bytes per stealstack, "
+            << sum_queue_bytes << " bytes summed over stealstacks, "
+            << "time-weighted average = " << static_cast<long long>(avg_queue_bytes)
+            << " bytes per stealstack\n";
+    if(queue_memory_cap != 0)
+    {
+        UTS_COUT
+            << "Queue memory cap = " << queue_memory_cap << " bytes, "
+            << "nodes expanded depth first = " << dfs_nodes
+            << " (" << (nodes ? 100.0 * dfs_nodes / nodes : 0.0) << "%)\n";
+    }
+    UTS_COUT
+        << "Peak RSS = " << max_rss << " bytes (max over " << rss_futures.size() << " localities) at "
+            << static_cast<long long>(nodes / walltime) << " nodes/sec\n"
+        << "\n" << UTS_FLUSH;
+}
+
+// summarize concurrent runs of independent trees
+inline void show_tenant_stats(double walltime, std::vector<double> completion_times,
+    std::vector<std::size_t> const & tenant_nodes, int verbose)
+{
+    std::size_t tnodes = std::accumulate(tenant_nodes.begin(), tenant_nodes.end(), std::size_t(0));
+    std::size_t num_tenants = completion_times.size();
+
+    std::sort(completion_times.begin(), completion_times.end());
+
+    double min_time = completion_times.front();
+    double max_time = completion_times.back();
+    double mean_time = std::accumulate(completion_times.begin(), completion_times.end(), 0.0) / num_tenants;
+    double median_time = completion_times[num_tenants / 2];
+    double p90_time = completion_times[
+        (std::min)(num_tenants - 1, static_cast<std::size_t>(std::ceil(0.9 * num_tenants)) - 1)];
+
+    std::size_t num_threads = hpx::get_num_worker_threads();
+
+    if (verbose == 0) {
+        UTS_COUT
+            << num_threads << " "
+            << num_tenants << " "
+            << walltime << " "
+            << tnodes << " "
+            << static_cast<long long>(tnodes/walltime) << " "
+            << min_time << " "
+            << median_time << " "
+            << p90_time << " "
+            << max_time << "\n"
+            << UTS_FLUSH;
+        return;
+    }
+
+    if (verbose > 1) {
+        for (std::size_t i = 0; i < tenant_nodes.size(); ++i) {
+            UTS_COUT << "  tenant " << i << ": " << tenant_nodes[i] << " nodes\n";
+        }
+    }
+
+    UTS_COUT
+        << "Tenants = " << num_tenants << ", "
+        << "total tree size = " << tnodes << "\n"
+        << "Wallclock time = " << walltime << " sec\n"
+        << "Aggregate performance = " << (tnodes / walltime) << " nodes/sec "
+        << "(" << (tnodes / walltime / num_threads) << " nodes/sec per PE)\n"
+        << "Tree completion time: min = " << min_time
+        << ", mean = " << mean_time
+        << ", median = " << median_time
+        << ", p90 = " << p90_time
+        << ", max = " << max_time << " sec\n"
+        << "\n" << UTS_FLUSH;
+}
+#endif
+
 #endif
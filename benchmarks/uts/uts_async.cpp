@@ -0,0 +1,170 @@
+//  Copyright (c) 2026 The STE||AR Group
+//
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+/*******************************************************************************
+ *
+ * UTS traversal expressed as plain recursive hpx::async calls on subtrees.
+ * There are no stealstacks, load balancing is left to the HPX scheduler.
+ * Nodes above the cutoff depth spawn one task per child, below the cutoff a
+ * task searches its subtree sequentially until it has visited node-budget
+ * nodes and then spawns one task for every node still on its stack.
+ *
+ * The search runs on the locality hpx_main is executed on.
+ *
+ ******************************************************************************/
+
+#include <benchmarks/uts/params.hpp>
+
+struct search_result
+{
+    search_result()
+      : n_nodes(0)
+      , n_leaves(0)
+      , n_tasks(0)
+      , max_tree_depth(0)
+    {}
+
+    search_result & operator+=(search_result const & rhs)
+    {
+        n_nodes += rhs.n_nodes;
+        n_leaves += rhs.n_leaves;
+        n_tasks += rhs.n_tasks;
+        max_tree_depth = (std::max)(max_tree_depth, rhs.max_tree_depth);
+        return *this;
+    }
+
+    std::size_t n_nodes;
+    std::size_t n_leaves;
+    std::size_t n_tasks;
+    std::size_t max_tree_depth;
+};
+
+params param;
+std::size_t cutoff_depth = 0;
+std::size_t node_budget = 0;
+
+search_result search(node n);
+
+// spawn one task for every node and combine their results
+search_result spawn_searches(std::vector<node> const & nodes)
+{
+    std::vector<hpx::future<search_result> > search_futures;
+    search_futures.reserve(nodes.size());
+    BOOST_FOREACH(node const & n, nodes)
+    {
+        search_futures.push_back(hpx::async(&search, n));
+    }
+
+    hpx::wait_all(search_futures);
+
+    search_result res;
+    BOOST_FOREACH(hpx::future<search_result> & f, search_futures)
+    {
+        res += f.get();
+    }
+    return res;
+}
+
+search_result search(node n)
+{
+    search_result res;
+    res.n_tasks = 1;
+
+    std::vector<node> work;
+
+    if(n.height < cutoff_depth)
+    {
+        gen_children(n, work, param, res);
+        res += spawn_searches(work);
+        return res;
+    }
+
+    work.push_back(n);
+    std::size_t visited = 0;
+    while(!work.empty())
+    {
+        if(node_budget != 0 && visited == node_budget)
+        {
+            res += spawn_searches(work);
+            return res;
+        }
+
+        node parent = work.back();
+        work.pop_back();
+        gen_children(parent, work, param, res);
+        ++visited;
+    }
+
+    return res;
+}
+
+int hpx_main(boost::program_options::variables_map & vm)
+{
+    param = params(vm);
+    param.disable_payload();
+    cutoff_depth = vm["cutoff-depth"].as<std::size_t>();
+    node_budget = vm["node-budget"].as<std::size_t>();
+
+    param.print("recursive async");
+    if(param.verbose > 0)
+    {
+        hpx::cout
+            << "Sequential cutoff depth = " << cutoff_depth
+            << ", node budget = " << node_budget << "\n\n" << hpx::flush;
+    }
+
+    node root;
+    root.init_root(param);
+
+    hpx::util::high_resolution_timer t;
+
+    search_result res = hpx::async(&search, root).get();
+
+    double elapsed = t.elapsed();
+
+    std::vector<worker_stats> stats(1);
+    stats[0].n_nodes = res.n_nodes;
+    stats[0].n_leaves = res.n_leaves;
+    stats[0].max_tree_depth = res.max_tree_depth;
+
+    // there are no chunks, the scheduler balances tasks, so the chunk size
+    // column of the stats line holds the average number of nodes per task
+    std::size_t nodes_per_task = (res.n_nodes + res.n_tasks / 2) / res.n_tasks;
+    show_stats(elapsed, stats, param.verbose, nodes_per_task, 1.0f);
+
+    if(param.verbose > 0)
+    {
+        std::size_t num_threads = hpx::get_num_worker_threads();
+        hpx::cout
+            << "Tasks spawned = " << res.n_tasks << " "
+            << "(" << static_cast<double>(res.n_nodes) / res.n_tasks << " nodes per task)\n"
+            << "PE time per task = "
+            << elapsed * num_threads / res.n_tasks * 1e6 << " microsec "
+            << "(derived from the throughput: walltime * PEs / tasks, not a task latency)\n"
+            << hpx::flush;
+    }
+
+    return hpx::finalize();
+}
+
+int main(int argc, char* argv[])
+{
+    boost::program_options::options_description desc = uts_params_desc();
+
+    desc.add_options()
+        (
+            "cutoff-depth"
+          , boost::program_options::value<std::size_t>()->default_value(2)
+          , "nodes above this depth spawn one task per child"
+        )
+        (
+            "node-budget"
+          , boost::program_options::value<std::size_t>()->default_value(1000)
+          , "number of nodes a task visits sequentially before it spawns its remaining work (0: unlimited)"
+        )
+        ;
+
+    return hpx::init(desc, argc, argv);
+}
@@ -0,0 +1,163 @@
+//  Copyright (c) 2026 The STE||AR Group
+//
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+/*******************************************************************************
+ *
+ * Writes the UTS tree given on the command line to a CSR file, which the
+ * stealstacks traverse when started with --csr-file (see csr.hpp).
+ *
+ * The tree is generated depth first, every node gets the next free indices
+ * for its children when it is expanded. By default the indices are then
+ * randomly permuted, so that neighbouring nodes are far apart in memory and
+ * visiting a node is a cache miss, as in large explicit graphs.
+ *
+ ******************************************************************************/
+
+#define UTS_NO_HPX
+
+#include <hpx/util/high_resolution_timer.hpp>
+
+#include <benchmarks/uts/csr.hpp>
+#include <benchmarks/uts/params.hpp>
+
+#include <boost/random/mersenne_twister.hpp>
+#include <boost/random/uniform_int_distribution.hpp>
+
+#include <iostream>
+#include <utility>
+
+int main(int argc, char* argv[])
+{
+    boost::program_options::options_description desc = uts_params_desc();
+
+    desc.add_options()
+        (
+            "help"
+          , "print this help message"
+        )
+        (
+            "output"
+          , boost::program_options::value<std::string>()->default_value("uts_tree.csr")
+          , "name of the CSR file to write"
+        )
+        (
+            "shuffle"
+          , boost::program_options::value<int>()->default_value(1)
+          , "nonzero to randomly permute the node indices"
+        )
+        (
+            "shuffle-seed"
+          , boost::program_options::value<boost::uint32_t>()->default_value(0)
+          , "seed of the permutation"
+        )
+        ;
+
+    boost::program_options::variables_map vm;
+    boost::program_options::store(
+        boost::program_options::parse_command_line(argc, argv, desc), vm);
+    boost::program_options::notify(vm);
+
+    if(vm.count("help"))
+    {
+        std::cout << desc << "\n";
+        return 0;
+    }
+
+    params param(vm);
+    param.compute_granularity = 1;
+    param.print("CSR generator", 1, 1);
+
+    hpx::util::high_resolution_timer t;
+
+    // index of the first child and number of children of every node
+    std::vector<boost::uint64_t> first_child;
+    std::vector<boost::uint32_t> num_children;
+    worker_stats stat;
+
+    {
+        std::vector<std::pair<node, boost::uint64_t> > stack;
+        std::vector<node> children;
+
+        node root;
+        root.init_root(param);
+        stack.push_back(std::make_pair(root, boost::uint64_t(0)));
+        first_child.push_back(0);
+        num_children.push_back(0);
+
+        while(!stack.empty())
+        {
+            node n = stack.back().first;
+            boost::uint64_t index = stack.back().second;
+            stack.pop_back();
+
+            children.clear();
+            gen_children(n, children, param, stat);
+
+            boost::uint64_t first = first_child.size();
+            first_child[index] = first;
+            num_children[index] = static_cast<boost::uint32_t>(children.size());
+
+            for(std::size_t i = 0; i < children.size(); ++i)
+            {
+                stack.push_back(std::make_pair(children[i], first + i));
+                first_child.push_back(0);
+                num_children.push_back(0);
+            }
+        }
+    }
+
+    boost::uint64_t num_nodes = first_child.size();
+
+    // perm[i] is the index of node i in the file
+    std::vector<boost::uint64_t> perm(num_nodes);
+    for(boost::uint64_t i = 0; i < num_nodes; ++i)
+    {
+        perm[i] = i;
+    }
+    if(vm["shuffle"].as<int>() != 0)
+    {
+        boost::random::mt19937 gen(vm["shuffle-seed"].as<boost::uint32_t>());
+        for(boost::uint64_t i = num_nodes - 1; i > 0; --i)
+        {
+            boost::random::uniform_int_distribution<boost::uint64_t> dist(0, i);
+            std::swap(perm[i], perm[dist(gen)]);
+        }
+    }
+
+    std::vector<boost::uint64_t> offsets(num_nodes + 1, 0);
+    for(boost::uint64_t i = 0; i < num_nodes; ++i)
+    {
+        offsets[perm[i] + 1] = num_children[i];
+    }
+    for(boost::uint64_t i = 0; i < num_nodes; ++i)
+    {
+        offsets[i + 1] += offsets[i];
+    }
+
+    std::vector<boost::uint64_t> children(offsets.back());
+    for(boost::uint64_t i = 0; i < num_nodes; ++i)
+    {
+        boost::uint64_t offset = offsets[perm[i]];
+        for(boost::uint32_t j = 0; j < num_children[i]; ++j)
+        {
+            children[offset + j] = perm[first_child[i] + j];
+        }
+    }
+
+    std::string filename = vm["output"].as<std::string>();
+    write_csr(filename, perm[0], offsets, children);
+
+    double elapsed = t.elapsed();
+
+    std::cout
+        << "Tree size = " << num_nodes << ", "
+        << "tree depth = " << stat.max_tree_depth << ", "
+        << "num leaves = " << stat.n_leaves << "\n"
+        << "Wrote " << filename << " ("
+            << sizeof(csr_header) + (2 * num_nodes) * sizeof(boost::uint64_t)
+            << " bytes) in " << elapsed << " sec\n";
+
+    return 0;
+}
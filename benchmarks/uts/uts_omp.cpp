@@ -0,0 +1,127 @@
+//  Copyright (c) 2026 The STE||AR Group
+//
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+/*******************************************************************************
+ *
+ * UTS baseline using OpenMP tasks, without the HPX runtime.
+ *
+ * A task searches its subtree depth first until it has visited chunk-size
+ * nodes, then it releases every node left on its stack as a new task and
+ * returns. No task ever waits for its children, the search is complete when
+ * the implicit barrier at the end of the parallel region is passed.
+ *
+ ******************************************************************************/
+
+#define UTS_NO_HPX
+
+#include <hpx/util/high_resolution_timer.hpp>
+
+#include <benchmarks/uts/params.hpp>
+
+#include <omp.h>
+
+#include <iostream>
+
+// per thread statistics, padded to avoid false sharing
+struct padded_stats
+{
+    worker_stats stat;
+    char pad[64];
+};
+
+params param;
+std::vector<padded_stats> thread_stats;
+
+void search(node n, bool released)
+{
+    worker_stats & stat = thread_stats[omp_get_thread_num()].stat;
+    if(released) ++stat.n_acquire;
+
+    std::vector<node> work;
+    work.reserve(param.chunk_size);
+    work.push_back(n);
+
+    std::size_t visited = 0;
+    while(!work.empty())
+    {
+        if(visited == param.chunk_size)
+        {
+            stat.n_release += work.size();
+            for(std::size_t i = 0; i < work.size(); ++i)
+            {
+                node child = work[i];
+                #pragma omp task firstprivate(child)
+                search(child, true);
+            }
+            return;
+        }
+
+        node parent = work.back();
+        work.pop_back();
+        gen_children(parent, work, param, stat);
+        stat.max_stack_depth = (std::max)(stat.max_stack_depth, work.size());
+        ++visited;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    boost::program_options::options_description desc = uts_params_desc();
+
+    desc.add_options()
+        (
+            "help"
+          , "print this help message"
+        )
+        (
+            "threads"
+          , boost::program_options::value<int>()->default_value(omp_get_max_threads())
+          , "number of OpenMP threads"
+        )
+        ;
+
+    boost::program_options::variables_map vm;
+    boost::program_options::store(
+        boost::program_options::parse_command_line(argc, argv, desc), vm);
+    boost::program_options::notify(vm);
+
+    if(vm.count("help"))
+    {
+        std::cout << desc << "\n";
+        return 0;
+    }
+
+    int num_threads = vm["threads"].as<int>();
+    omp_set_num_threads(num_threads);
+
+    param = params(vm);
+    param.disable_payload();
+    param.print("OpenMP tasks", num_threads, 1);
+
+    thread_stats.resize(num_threads);
+
+    node root;
+    root.init_root(param);
+
+    hpx::util::high_resolution_timer t;
+
+    #pragma omp parallel
+    {
+        #pragma omp single nowait
+        search(root, false);
+    }
+
+    double elapsed = t.elapsed();
+
+    std::vector<worker_stats> stats;
+    stats.reserve(num_threads);
+    BOOST_FOREACH(padded_stats const & s, thread_stats)
+    {
+        stats.push_back(s.stat);
+    }
+    show_stats(elapsed, stats, param.verbose, param.chunk_size, 1.0f, num_threads);
+
+    return 0;
+}
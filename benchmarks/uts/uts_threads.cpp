@@ -0,0 +1,234 @@
+//  Copyright (c) 2026 The STE||AR Group
+//
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+/*******************************************************************************
+ *
+ * UTS baseline using a pool of std::threads with per thread deques of chunks
+ * and random work stealing, without the HPX runtime.
+ *
+ * Every thread searches depth first on a private stack. Whenever the private
+ * stack holds more than 2 * chunk-size nodes, the chunk-size oldest nodes are
+ * released into the thread's deque. Owners take chunks from the front of
+ * their deque, thieves take them from the back.
+ *
+ ******************************************************************************/
+
+#define UTS_NO_HPX
+
+#include <hpx/util/high_resolution_timer.hpp>
+
+#include <benchmarks/uts/params.hpp>
+
+#include <atomic>
+#include <deque>
+#include <iostream>
+#include <mutex>
+#include <random>
+#include <thread>
+
+struct worker
+{
+    std::mutex mtx;
+    std::deque<stealstack_node> queue;
+    worker_stats stat;
+    char pad[64];
+};
+
+params param;
+std::vector<worker> workers;
+
+// number of threads which hold work or are about to take a chunk
+std::atomic<std::size_t> active(0);
+
+// number of chunks taken from any deque so far
+std::atomic<std::size_t> taken(0);
+
+bool take_own(std::size_t rank, std::vector<node> & work)
+{
+    worker & w = workers[rank];
+    std::lock_guard<std::mutex> lk(w.mtx);
+    if(w.queue.empty()) return false;
+
+    std::swap(work, w.queue.front().work);
+    w.queue.pop_front();
+    ++taken;
+    ++w.stat.n_acquire;
+    return true;
+}
+
+bool steal(std::size_t victim, std::vector<node> & work)
+{
+    worker & w = workers[victim];
+    std::lock_guard<std::mutex> lk(w.mtx);
+    if(w.queue.empty()) return false;
+
+    std::swap(work, w.queue.back().work);
+    w.queue.pop_back();
+    ++taken;
+    return true;
+}
+
+void release(std::size_t rank, std::vector<node> & work)
+{
+    stealstack_node chunk(param.chunk_size);
+    chunk.work.assign(work.begin(), work.begin() + param.chunk_size);
+    work.erase(work.begin(), work.begin() + param.chunk_size);
+
+    worker & w = workers[rank];
+    std::lock_guard<std::mutex> lk(w.mtx);
+    w.queue.push_front(stealstack_node());
+    w.queue.front().swap(chunk);
+    ++w.stat.n_release;
+    w.stat.max_stack_depth = (std::max)(w.stat.max_stack_depth,
+        w.queue.size() * param.chunk_size);
+}
+
+// The search is over once no thread holds work and all deques are empty.
+// Only threads holding work push chunks and a thread only gets work by
+// taking a chunk, which counts up taken while the deque is locked. If no
+// thread was active before the sweep and no chunk was taken during it, no
+// chunk can have moved between deques behind the back of the sweep.
+bool terminated()
+{
+    std::size_t taken_before = taken;
+    if(active != 0) return false;
+
+    BOOST_FOREACH(worker & w, workers)
+    {
+        std::lock_guard<std::mutex> lk(w.mtx);
+        if(!w.queue.empty()) return false;
+    }
+
+    return taken == taken_before;
+}
+
+// Wait for work. Returns false once the search terminated. The calling
+// thread stays active until it failed to take a chunk from its own deque
+// and to steal one, and becomes active again before it retries.
+bool acquire(std::size_t rank, std::vector<node> & work, std::mt19937 & gen)
+{
+    worker_stats & stat = workers[rank].stat;
+    std::uniform_int_distribution<std::size_t> dist(0, workers.size() - 1);
+
+    while(true)
+    {
+        if(take_own(rank, work)) return true;
+
+        if(workers.size() > 1)
+        {
+            std::size_t victim = dist(gen);
+            if(victim == rank) victim = (victim + 1) % workers.size();
+
+            if(steal(victim, work))
+            {
+                ++stat.n_steal;
+                return true;
+            }
+            ++stat.n_fail;
+        }
+        --active;
+
+        if(terminated()) return false;
+        std::this_thread::yield();
+        ++active;
+    }
+}
+
+void search(std::size_t rank)
+{
+    std::mt19937 gen(static_cast<std::mt19937::result_type>(rank));
+    worker_stats & stat = workers[rank].stat;
+
+    std::vector<node> work;
+    work.reserve(2 * param.chunk_size + MAX_NUM_CHILDREN);
+
+    while(true)
+    {
+        if(work.empty() && !acquire(rank, work, gen)) return;
+
+        node parent = work.back();
+        work.pop_back();
+        gen_children(parent, work, param, stat);
+
+        if(work.size() > 2 * param.chunk_size)
+        {
+            release(rank, work);
+        }
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    boost::program_options::options_description desc = uts_params_desc();
+
+    desc.add_options()
+        (
+            "help"
+          , "print this help message"
+        )
+        (
+            "threads"
+          , boost::program_options::value<std::size_t>()->default_value(
+                (std::max)(1u, std::thread::hardware_concurrency()))
+          , "number of threads"
+        )
+        ;
+
+    boost::program_options::variables_map vm;
+    boost::program_options::store(
+        boost::program_options::parse_command_line(argc, argv, desc), vm);
+    boost::program_options::notify(vm);
+
+    if(vm.count("help"))
+    {
+        std::cout << desc << "\n";
+        return 0;
+    }
+
+    std::size_t num_threads = vm["threads"].as<std::size_t>();
+
+    param = params(vm);
+    param.disable_payload();
+    param.print("std::thread work stealing", num_threads, 1);
+
+    workers = std::vector<worker>(num_threads);
+
+    {
+        node root;
+        root.init_root(param);
+
+        stealstack_node chunk(param.chunk_size);
+        chunk.work.push_back(root);
+        workers[0].queue.push_back(chunk);
+        ++workers[0].stat.n_release;
+    }
+
+    hpx::util::high_resolution_timer t;
+
+    active = num_threads;
+
+    std::vector<std::thread> threads;
+    threads.reserve(num_threads);
+    for(std::size_t i = 0; i < num_threads; ++i)
+    {
+        threads.push_back(std::thread(&search, i));
+    }
+    BOOST_FOREACH(std::thread & thread, threads)
+    {
+        thread.join();
+    }
+
+    double elapsed = t.elapsed();
+
+    std::vector<worker_stats> stats;
+    stats.reserve(num_threads);
+    BOOST_FOREACH(worker const & w, workers)
+    {
+        stats.push_back(w.stat);
+    }
+    show_stats(elapsed, stats, param.verbose, param.chunk_size, 1.0f, num_threads);
+
+    return 0;
+}
@@ -0,0 +1,281 @@
+//  Copyright (c) 2026 The STE||AR Group
+//
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+/*******************************************************************************
+ *
+ * Auto-tuner for the work stealing search. Runs truncated searches of the
+ * tree given on the command line for every combination of chunk size,
+ * overcommit factor and steal policy, either exhaustively (grid) or by
+ * successive halving: every round runs the remaining configurations with
+ * twice the node budget of the previous round and keeps the faster half.
+ * The best configuration is printed as an export line in the style of
+ * sample_trees.sh, to be used as e.g. uts_ws $T1 $UTS_TUNED.
+ *
+ ******************************************************************************/
+
+#include <benchmarks/uts/params.hpp>
+#include <benchmarks/uts/ws_stealstack.hpp>
+
+#include <boost/lexical_cast.hpp>
+
+#include <algorithm>
+#include <sstream>
+#include <string>
+#include <vector>
+
+HPX_REGISTER_MINIMAL_COMPONENT_FACTORY(
+    hpx::components::managed_component< ::components::ws_stealstack>
+  , ws_stealstack_component);
+
+struct tune_config
+{
+    tune_config()
+      : chunk_size(0)
+      , overcommit_factor(1.0f)
+      , steal_policy(params::STEAL_ROUND_ROBIN)
+      , nodes(0)
+      , time(0.0)
+      , nodes_per_sec(0.0)
+    {}
+
+    std::size_t chunk_size;
+    float overcommit_factor;
+    params::steal_policy_type steal_policy;
+
+    // best of the repetitions of the last measurement
+    std::size_t nodes;
+    double time;
+    double nodes_per_sec;
+};
+
+inline bool faster(tune_config const & lhs, tune_config const & rhs)
+{
+    return lhs.nodes_per_sec > rhs.nodes_per_sec;
+}
+
+// parse a comma separated list of values, e.g. "10,20,50"
+template <typename T>
+std::vector<T> parse_list(std::string const & list)
+{
+    std::vector<T> res;
+    std::istringstream is(list);
+    std::string item;
+    while(std::getline(is, item, ','))
+    {
+        if(item.empty()) continue;
+        res.push_back(boost::lexical_cast<T>(item));
+    }
+    return res;
+}
+
+// run a search truncated after max_nodes nodes with the given configuration
+void run_config(params p, tune_config & config, std::size_t max_nodes, std::size_t repeats)
+{
+    p.chunk_size = config.chunk_size;
+    p.steal_policy = config.steal_policy;
+    p.max_nodes = max_nodes;
+
+    config.nodes = 0;
+    config.time = 0.0;
+    config.nodes_per_sec = 0.0;
+
+    for(std::size_t r = 0; r < repeats; ++r)
+    {
+        std::vector<hpx::id_type> stealstacks =
+            create_stealstacks<components::ws_stealstack>(p, config.overcommit_factor);
+
+        hpx::util::high_resolution_timer t;
+
+        std::vector<hpx::future<void> > tree_search_futures;
+        tree_search_futures.reserve(stealstacks.size());
+        BOOST_FOREACH(hpx::id_type const & id, stealstacks)
+        {
+            tree_search_futures.push_back(
+                hpx::async<components::ws_stealstack::tree_search_action>(id)
+            );
+        }
+        hpx::wait_all(tree_search_futures);
+
+        double elapsed = t.elapsed();
+
+        std::vector<hpx::future<components::ws_stealstack::stats> > stats_futures;
+        stats_futures.reserve(stealstacks.size());
+        BOOST_FOREACH(hpx::id_type const & id, stealstacks)
+        {
+            stats_futures.push_back(
+                hpx::async<components::ws_stealstack::get_stats_action>(id)
+            );
+        }
+        hpx::wait_all(stats_futures);
+
+        std::size_t nodes = 0;
+        BOOST_FOREACH(hpx::future<components::ws_stealstack::stats> & f, stats_futures)
+        {
+            nodes += f.get().n_nodes;
+        }
+
+        double rate = nodes / elapsed;
+        if(rate > config.nodes_per_sec)
+        {
+            config.nodes = nodes;
+            config.time = elapsed;
+            config.nodes_per_sec = rate;
+        }
+    }
+
+    hpx::cout
+        << config.chunk_size << " "
+        << config.overcommit_factor << " "
+        << static_cast<int>(config.steal_policy) << " "
+        << max_nodes << " "
+        << config.nodes << " "
+        << config.time << " "
+        << static_cast<long long>(config.nodes_per_sec) << "\n"
+        << hpx::flush;
+}
+
+int hpx_main(boost::program_options::variables_map & vm)
+{
+    params p(vm);
+    p.print("workstealing auto-tuner");
+
+    std::vector<std::size_t> chunk_sizes =
+        parse_list<std::size_t>(vm["tune-chunk-sizes"].as<std::string>());
+    std::vector<float> overcommit_factors =
+        parse_list<float>(vm["tune-overcommit-factors"].as<std::string>());
+    std::vector<int> steal_policies =
+        parse_list<int>(vm["tune-steal-policies"].as<std::string>());
+
+    std::string search = vm["tune-search"].as<std::string>();
+    std::size_t max_nodes = vm["tune-nodes"].as<std::size_t>();
+    std::size_t repeats = (std::max)(vm["tune-repeats"].as<std::size_t>(), std::size_t(1));
+
+    std::vector<tune_config> configs;
+    BOOST_FOREACH(std::size_t chunk_size, chunk_sizes)
+    {
+        BOOST_FOREACH(float overcommit_factor, overcommit_factors)
+        {
+            BOOST_FOREACH(int steal_policy, steal_policies)
+            {
+                tune_config config;
+                config.chunk_size = chunk_size;
+                config.overcommit_factor = overcommit_factor;
+                config.steal_policy = steal_policy == params::STEAL_LOAD_WEIGHTED
+                    ? params::STEAL_LOAD_WEIGHTED : params::STEAL_ROUND_ROBIN;
+                configs.push_back(config);
+            }
+        }
+    }
+
+    if(configs.empty())
+    {
+        hpx::cout << "*** no configurations to tune\n" << hpx::flush;
+        return hpx::finalize();
+    }
+
+    hpx::cout << "# chunk-size overcommit-factor steal-policy max-nodes nodes time nodes/sec\n"
+        << hpx::flush;
+
+    if(search == "grid")
+    {
+        BOOST_FOREACH(tune_config & config, configs)
+        {
+            run_config(p, config, max_nodes, repeats);
+        }
+        std::stable_sort(configs.begin(), configs.end(), faster);
+    }
+    else if(search == "halving")
+    {
+        // the last round, with two configurations left, runs with max_nodes
+        std::size_t rounds = 1;
+        for(std::size_t n = configs.size(); n > 2; n = (n + 1) / 2)
+        {
+            ++rounds;
+        }
+        // max_nodes == 0 runs complete searches in every round
+        std::size_t round_nodes = max_nodes >> (rounds - 1);
+        if(max_nodes != 0 && round_nodes == 0) round_nodes = 1;
+
+        while(true)
+        {
+            BOOST_FOREACH(tune_config & config, configs)
+            {
+                run_config(p, config, round_nodes, repeats);
+            }
+            std::stable_sort(configs.begin(), configs.end(), faster);
+
+            if(configs.size() <= 2) break;
+
+            configs.resize((configs.size() + 1) / 2);
+            round_nodes *= 2;
+        }
+    }
+    else
+    {
+        hpx::cout << "*** unknown search " << search << ", use grid or halving\n" << hpx::flush;
+        return hpx::finalize();
+    }
+
+    tune_config const & best = configs.front();
+
+    hpx::cout
+        << "\n"
+        << "# (" << vm["tune-name"].as<std::string>() << ") "
+            << static_cast<long long>(best.nodes_per_sec) << " nodes/sec with "
+            << hpx::get_num_worker_threads() << " threads\n"
+        << "export " << vm["tune-name"].as<std::string>() << "=\""
+            << "--chunk-size " << best.chunk_size
+            << " --overcommit-factor " << best.overcommit_factor
+            << " --steal-policy " << static_cast<int>(best.steal_policy) << "\"\n"
+        << hpx::flush;
+
+    return hpx::finalize();
+}
+
+int main(int argc, char* argv[])
+{
+    boost::program_options::options_description desc = uts_params_desc();
+
+    desc.add_options()
+        (
+            "tune-chunk-sizes"
+          , boost::program_options::value<std::string>()->default_value("5,10,20,50,100")
+          , "comma separated list of chunk sizes to try"
+        )
+        (
+            "tune-overcommit-factors"
+          , boost::program_options::value<std::string>()->default_value("1,2,4")
+          , "comma separated list of overcommit factors to try"
+        )
+        (
+            "tune-steal-policies"
+          , boost::program_options::value<std::string>()->default_value("0,1")
+          , "comma separated list of steal policies to try"
+        )
+        (
+            "tune-search"
+          , boost::program_options::value<std::string>()->default_value("halving")
+          , "search strategy (grid: run every configuration with tune-nodes nodes, "
+            "halving: successive halving ending with tune-nodes nodes)"
+        )
+        (
+            "tune-nodes"
+          , boost::program_options::value<std::size_t>()->default_value(1000000)
+          , "number of nodes after which a search is truncated"
+        )
+        (
+            "tune-repeats"
+          , boost::program_options::value<std::size_t>()->default_value(1)
+          , "number of runs per configuration, the fastest counts"
+        )
+        (
+            "tune-name"
+          , boost::program_options::value<std::string>()->default_value("UTS_TUNED")
+          , "name of the exported shell variable"
+        )
+        ;
+
+    return hpx::init(desc, argc, argv);
+}
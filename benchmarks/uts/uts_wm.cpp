@@ -35,7 +35,17 @@ int hpx_main(boost::program_options::variables_map & vm)
         );
     }
 
-    hpx::wait(tree_search_futures);
+    int sample_interval = vm["sample-interval"].as<int>();
+    std::vector<timeline_sample> timeline;
+    if(sample_interval > 0)
+    {
+        timeline = sample_timeline<components::wm_stealstack>(
+            stealstacks, tree_search_futures, sample_interval);
+    }
+    else
+    {
+        hpx::wait_all(tree_search_futures);
+    }
 
     double elapsed = t.elapsed();
 
@@ -52,8 +62,51 @@ int hpx_main(boost::program_options::variables_map & vm)
 
     std::vector<components::wm_stealstack::stats> stats;
     stats.reserve(stealstacks.size());
-    hpx::wait(stats_futures, stats);
+    hpx::wait_all(stats_futures);
+    BOOST_FOREACH(hpx::future<components::wm_stealstack::stats> & f, stats_futures)
+    {
+        stats.push_back(f.get());
+    }
     show_stats(elapsed, stats, vm["verbose"].as<int>(), vm["chunk-size"].as<std::size_t>(), vm["overcommit-factor"].as<float>());
+    show_straggler_stats(stats);
+    std::size_t queue_memory_cap = vm["queue-memory-cap"].as<std::size_t>();
+    if(vm["verbose"].as<int>() > 0 || queue_memory_cap != 0)
+    {
+        show_memory_stats(elapsed, stats, queue_memory_cap);
+    }
+
+    if(sample_interval > 0)
+    {
+        show_timeline(timeline, sample_interval);
+    }
+
+    if(vm["verbose"].as<int>() != 0)
+    {
+        std::size_t share_msgs = 0, ack_msgs = 0, chunks = 0;
+        BOOST_FOREACH(components::wm_stealstack::stats const & stat, stats)
+        {
+            share_msgs += stat.n_share_msgs;
+            ack_msgs += stat.n_ack_msgs;
+            chunks += stat.n_release;
+        }
+        hpx::cout
+            << "Share messages = " << share_msgs << " carrying " << chunks << " chunks"
+                << " (" << (share_msgs ? static_cast<double>(chunks) / share_msgs : 0.0)
+                << " chunks per message), ack messages = " << ack_msgs
+                << ", share batch = " << vm["share-batch"].as<std::size_t>() << "\n"
+            << "\n" << hpx::flush;
+    }
+
+    if(vm["reduce"].as<int>())
+    {
+        show_summary(reduce_summaries<components::wm_stealstack>(stealstacks));
+    }
+
+    if(vm["debug"].as<int>() & UTS_DEBUG_TRACE)
+    {
+        write_trace<components::wm_stealstack>(
+            stealstacks, vm["trace-file"].as<std::string>());
+    }
 
     return hpx::finalize();
 }
@@ -13,17 +13,18 @@
 #include <benchmarks/uts/params.hpp>
 #include <benchmarks/uts/ws_stealstack.hpp>
 
+#include <hpx/util/high_resolution_clock.hpp>
+
+#include <boost/lexical_cast.hpp>
+
 HPX_REGISTER_MINIMAL_COMPONENT_FACTORY(
     hpx::components::managed_component< ::components::ws_stealstack>
   , ws_stealstack_component);
 
-int hpx_main(boost::program_options::variables_map & vm)
+// run the search on one group of stealstacks, returns the time in seconds
+// between start and the completion of the search
+double tree_search(std::vector<hpx::id_type> const & stealstacks, boost::uint64_t start)
 {
-    std::vector<hpx::id_type> stealstacks =
-        create_stealstacks<components::ws_stealstack>(vm, "workstealing");
-
-    hpx::util::high_resolution_timer t;
-
     std::vector<hpx::future<void> > tree_search_futures;
     tree_search_futures.reserve(stealstacks.size());
     BOOST_FOREACH(hpx::id_type const & id, stealstacks)
@@ -37,8 +38,12 @@ int hpx_main(boost::program_options::variables_map & vm)
 
     hpx::wait_all(tree_search_futures);
 
-    double elapsed = t.elapsed();
+    return (hpx::util::high_resolution_clock::now() - start) * 1e-9;
+}
 
+std::vector<components::ws_stealstack::stats>
+get_stats(std::vector<hpx::id_type> const & stealstacks)
+{
     std::vector<hpx::future<components::ws_stealstack::stats> > stats_futures;
     stats_futures.reserve(stealstacks.size());
     BOOST_FOREACH(hpx::id_type const & id, stealstacks)
@@ -57,7 +62,222 @@ int hpx_main(boost::program_options::variables_map & vm)
     {
         stats.push_back(stat_fut.get());
     }
+    return stats;
+}
+
+// Switch the stealstacks to recording or replaying their steal decisions.
+// A replayed schedule has to come from a run with the same tree, chunk size
+// and number of stealstacks.
+void start_schedule(boost::program_options::variables_map & vm,
+    std::vector<hpx::id_type> const & stealstacks)
+{
+    std::string replay = vm["steal-replay"].as<std::string>();
+    if(!replay.empty())
+    {
+        std::vector<std::vector<boost::uint64_t> > schedules = read_schedule(replay);
+        if(schedules.size() != stealstacks.size())
+        {
+            throw std::logic_error("start_schedule(): " + replay + " was recorded with "
+                + boost::lexical_cast<std::string>(schedules.size()) + " stealstacks, not "
+                + boost::lexical_cast<std::string>(stealstacks.size()));
+        }
+
+        std::vector<hpx::future<void> > replay_futures;
+        replay_futures.reserve(stealstacks.size());
+        for(std::size_t i = 0; i < stealstacks.size(); ++i)
+        {
+            replay_futures.push_back(
+                hpx::async<components::ws_stealstack::replay_schedule_action>(
+                    stealstacks[i], schedules[i])
+            );
+        }
+        hpx::wait_all(replay_futures);
+    }
+    else if(!vm["steal-record"].as<std::string>().empty())
+    {
+        std::vector<hpx::future<void> > record_futures;
+        record_futures.reserve(stealstacks.size());
+        BOOST_FOREACH(hpx::id_type const & id, stealstacks)
+        {
+            record_futures.push_back(
+                hpx::async<components::ws_stealstack::record_schedule_action>(id)
+            );
+        }
+        hpx::wait_all(record_futures);
+    }
+}
+
+void finish_schedule(boost::program_options::variables_map & vm,
+    std::vector<hpx::id_type> const & stealstacks,
+    std::vector<components::ws_stealstack::stats> const & stats)
+{
+    std::string replay = vm["steal-replay"].as<std::string>();
+    std::string record = vm["steal-record"].as<std::string>();
+    if(!replay.empty())
+    {
+        std::size_t replayed = 0, diverged = 0;
+        BOOST_FOREACH(components::ws_stealstack::stats const & stat, stats)
+        {
+            replayed += stat.n_replayed;
+            diverged += stat.n_diverged;
+        }
+        hpx::cout
+            << "Replayed " << replayed << " steal attempts from " << replay
+                << ", " << diverged << " with a different outcome\n"
+            << "\n" << hpx::flush;
+    }
+    else if(!record.empty())
+    {
+        std::vector<hpx::future<std::vector<boost::uint64_t> > > schedule_futures;
+        schedule_futures.reserve(stealstacks.size());
+        BOOST_FOREACH(hpx::id_type const & id, stealstacks)
+        {
+            schedule_futures.push_back(
+                hpx::async<components::ws_stealstack::get_schedule_action>(id)
+            );
+        }
+        hpx::wait_all(schedule_futures);
+
+        std::vector<std::vector<boost::uint64_t> > schedules;
+        schedules.reserve(stealstacks.size());
+        std::size_t steals = 0;
+        BOOST_FOREACH(hpx::future<std::vector<boost::uint64_t> > & f, schedule_futures)
+        {
+            schedules.push_back(f.get());
+            steals += schedules.back().size();
+        }
+
+        write_schedule(record, schedules);
+
+        hpx::cout
+            << "Wrote " << steals << " steal attempts to " << record << "\n"
+            << "\n" << hpx::flush;
+    }
+}
+
+int run_tenants(boost::program_options::variables_map & vm, std::size_t num_tenants)
+{
+    params p(vm);
+    p.print("workstealing");
+
+    float overcommit_factor = vm["overcommit-factor"].as<float>();
+
+    // every tenant searches its own tree with its own group of stealstacks
+    std::vector<std::vector<hpx::id_type> > tenants;
+    tenants.reserve(num_tenants);
+    for(std::size_t i = 0; i < num_tenants; ++i)
+    {
+        params tenant_param(p);
+        tenant_param.root_id = p.root_id + static_cast<int>(i);
+        tenants.push_back(
+            create_stealstacks<components::ws_stealstack>(tenant_param, overcommit_factor));
+    }
+
+    hpx::util::high_resolution_timer t;
+    boost::uint64_t start = hpx::util::high_resolution_clock::now();
+
+    std::vector<hpx::future<double> > tenant_futures;
+    tenant_futures.reserve(num_tenants);
+    BOOST_FOREACH(std::vector<hpx::id_type> const & stealstacks, tenants)
+    {
+        tenant_futures.push_back(hpx::async(&tree_search, stealstacks, start));
+    }
+
+    hpx::wait_all(tenant_futures);
+
+    double elapsed = t.elapsed();
+
+    std::vector<double> completion_times;
+    completion_times.reserve(num_tenants);
+    BOOST_FOREACH(hpx::future<double> & f, tenant_futures)
+    {
+        completion_times.push_back(f.get());
+    }
+
+    std::vector<std::size_t> tenant_nodes;
+    tenant_nodes.reserve(num_tenants);
+    for(std::size_t i = 0; i < num_tenants; ++i)
+    {
+        std::vector<components::ws_stealstack::stats> stats = get_stats(tenants[i]);
+
+        std::size_t tnodes = 0;
+        BOOST_FOREACH(components::ws_stealstack::stats const & stat, stats)
+        {
+            tnodes += stat.n_nodes;
+        }
+        tenant_nodes.push_back(tnodes);
+
+        if(p.debug & UTS_DEBUG_TRACE)
+        {
+            write_trace<components::ws_stealstack>(tenants[i],
+                vm["trace-file"].as<std::string>() + "." + boost::lexical_cast<std::string>(i));
+        }
+    }
+
+    show_tenant_stats(elapsed, completion_times, tenant_nodes, p.verbose);
+
+    return hpx::finalize();
+}
+
+int hpx_main(boost::program_options::variables_map & vm)
+{
+    std::size_t num_tenants = vm["tenants"].as<std::size_t>();
+    if(num_tenants > 1)
+    {
+        return run_tenants(vm, num_tenants);
+    }
+
+    std::vector<hpx::id_type> stealstacks =
+        create_stealstacks<components::ws_stealstack>(vm, "workstealing");
+
+    start_schedule(vm, stealstacks);
+
+    int sample_interval = vm["sample-interval"].as<int>();
+    std::vector<timeline_sample> timeline;
+
+    hpx::util::high_resolution_timer t;
+
+    double elapsed = 0.0;
+    if(sample_interval > 0)
+    {
+        std::vector<hpx::future<double> > search;
+        search.push_back(hpx::async(&tree_search, stealstacks,
+            hpx::util::high_resolution_clock::now()));
+        timeline = sample_timeline<components::ws_stealstack>(
+            stealstacks, search, sample_interval);
+        elapsed = search[0].get();
+    }
+    else
+    {
+        tree_search(stealstacks, hpx::util::high_resolution_clock::now());
+        elapsed = t.elapsed();
+    }
+
+    std::vector<components::ws_stealstack::stats> stats = get_stats(stealstacks);
     show_stats(elapsed, stats, vm["verbose"].as<int>(), vm["chunk-size"].as<std::size_t>(), vm["overcommit-factor"].as<float>());
+    show_straggler_stats(stats);
+    std::size_t queue_memory_cap = vm["queue-memory-cap"].as<std::size_t>();
+    if(vm["verbose"].as<int>() > 0 || queue_memory_cap != 0)
+    {
+        show_memory_stats(elapsed, stats, queue_memory_cap);
+    }
+    finish_schedule(vm, stealstacks, stats);
+
+    if(sample_interval > 0)
+    {
+        show_timeline(timeline, sample_interval);
+    }
+
+    if(vm["reduce"].as<int>())
+    {
+        show_summary(reduce_summaries<components::ws_stealstack>(stealstacks));
+    }
+
+    if(vm["debug"].as<int>() & UTS_DEBUG_TRACE)
+    {
+        write_trace<components::ws_stealstack>(
+            stealstacks, vm["trace-file"].as<std::string>());
+    }
 
     return hpx::finalize();
 }
@@ -65,5 +285,25 @@ int hpx_main(boost::program_options::variables_map & vm)
 int main(int argc, char* argv[])
 {
     boost::program_options::options_description desc = uts_params_desc();
+
+    desc.add_options()
+        (
+            "tenants"
+          , boost::program_options::value<std::size_t>()->default_value(1)
+          , "number of independent trees searched concurrently, tenant i uses root seed root-seed + i"
+        )
+        (
+            "steal-record"
+          , boost::program_options::value<std::string>()->default_value("")
+          , "write the steal decisions of every stealstack to this file"
+        )
+        (
+            "steal-replay"
+          , boost::program_options::value<std::string>()->default_value("")
+          , "repeat the steal decisions recorded with steal-record, requires the same "
+            "tree, chunk size and number of stealstacks"
+        )
+        ;
+
     return hpx::init(desc, argc, argv);
 }
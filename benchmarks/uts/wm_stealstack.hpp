@@ -7,9 +7,16 @@
 #ifndef BENCHMARKS_UTS_WM_STEALSTACK_HPP
 #define BENCHMARKS_UTS_WM_STEALSTACK_HPP
 
+#include <benchmarks/uts/csr.hpp>
+#include <benchmarks/uts/load_table.hpp>
 #include <benchmarks/uts/params.hpp>
+#include <benchmarks/uts/reduction.hpp>
+#include <benchmarks/uts/timeline.hpp>
+#include <benchmarks/uts/trace.hpp>
 #include <hpx/include/async.hpp>
 #include <hpx/include/components.hpp>
+#include <hpx/util/high_resolution_clock.hpp>
+#include <hpx/util/high_resolution_timer.hpp>
 
 namespace components
 {
@@ -36,6 +43,13 @@ namespace components
               , n_fail(0)
               , max_stack_depth(0)
               , max_tree_depth(0)
+              , completion_time(0.0)
+              , slow(false)
+              , max_queue_bytes(0)
+              , avg_queue_bytes(0.0)
+              , n_dfs_nodes(0)
+              , n_share_msgs(0)
+              , n_ack_msgs(0)
             {
                 time[WORK] = 0.0;
                 time[SEARCH] = 0.0;
@@ -57,6 +71,16 @@ namespace components
                 ar & max_tree_depth;
 
                 ar & time;
+
+                ar & completion_time;
+                ar & slow;
+
+                ar & max_queue_bytes;
+                ar & avg_queue_bytes;
+                ar & n_dfs_nodes;
+
+                ar & n_share_msgs;
+                ar & n_ack_msgs;
             }
 
             std::size_t n_nodes;
@@ -70,10 +94,47 @@ namespace components
             std::size_t max_tree_depth;
 
             double time[NSTATES];
+
+            double completion_time;     // seconds until the last chunk was expanded
+            bool slow;                  // slowed down by --slow-ranks
+
+            std::size_t max_queue_bytes;    // peak memory held by local_queue
+            double avg_queue_bytes;         // time-weighted average over tree_search
+            std::size_t n_dfs_nodes;        // nodes expanded in bounded memory mode
+
+            std::size_t n_share_msgs;   // share_work parcels sent
+            std::size_t n_ack_msgs;     // ack_share parcels sent
+        };
+
+        // Shares and acknowledgements waiting to be sent to one destination,
+        // see --share-batch
+        struct outbox
+        {
+            outbox()
+              : nodes(0)
+              , acks(0)
+              , ack_msgs(0)
+              , since(0)
+            {}
+
+            std::vector<stealstack_node> chunks;
+            std::size_t nodes;          // nodes in chunks
+            std::size_t acks;           // received nodes not yet acknowledged
+            std::size_t ack_msgs;       // received shares not yet acknowledged
+            boost::uint64_t since;      // time the oldest entry was buffered, 0 if empty
         };
 
         wm_stealstack()
           : local_work(0)
+          , local_cost(0)
+          , nodes_done(0)
+          , dfs_nodes(0)
+          , share_msgs(0)
+          , ack_msgs(0)
+          , active(false)
+          , queue_bytes(0)
+          , queue_byte_ns(0.0)
+          , queue_bytes_since(0)
           , work_shared(0)
           , walltime(0)
           , work_time(0)
@@ -88,6 +149,7 @@ namespace components
           , ctrl_recvd(0)
           , ctrl_sent(0)
           , pollint_adaptive(false)
+          , slow(false)
         {
         }
 
@@ -100,20 +162,46 @@ namespace components
             size = s;
             param = p;
 
+            slow = p.is_slow(rank);
+            stat.slow = slow;
+
             last_steal = rank;
             last_share = rank;
 
+            loads.init(rank, size);
+            outboxes.resize(size);
+
+            if(p.debug & UTS_DEBUG_TRACE)
+            {
+                trace.init(rank, hpx::get_os_thread_count(), p.trace_buffer_size);
+            }
+
             if(p.polling_interval == 0)
             {
                 pollint_adaptive = true;
                 p.polling_interval = 1;
             }
 
+            if(p.reduce)
+            {
+                summary.init(hpx::get_os_thread_count());
+            }
+
+            if(!p.csr_file.empty())
+            {
+                csr.open(p.csr_file);
+            }
+
             if(rank == 0)
             {
                 node n;
                 n.init_root(param);
-                put_work(n);
+                if(csr.is_open())
+                {
+                    n.set_csr_index(csr.root());
+                }
+                std::vector<char> payload(param.payload_bytes, 'a');
+                put_work(n, payload.empty() ? 0 : &payload[0]);
             }
         }
 
@@ -126,23 +214,26 @@ namespace components
 
         HPX_DEFINE_COMPONENT_ACTION(wm_stealstack, resolve_names);
 
-        void put_work(node const & n)
+        void put_work(node const & n, char const * payload)
         {
+            std::size_t c = param.balance_by_cost ? n.cost(param) : 0;
             {
                 mutex_type::scoped_lock lk(local_queue_mtx);
                 /* If the stack is empty, push an empty stealstack_node. */
                 if(local_queue.empty())
                 {
-                    stealstack_node node(param.chunk_size);
+                    stealstack_node node(param.chunk_size, param.payload_bytes);
                     local_queue.push_front(node);
+                    add_queue_bytes(local_queue.front().bytes());
                 }
 
 
                 /* If the current stealstack_node is full, push a new one. */
                 if(local_queue.front().work.size() == param.chunk_size)
                 {
-                    stealstack_node node(param.chunk_size);
+                    stealstack_node node(param.chunk_size, param.payload_bytes);
                     local_queue.push_front(node);
+                    add_queue_bytes(local_queue.front().bytes());
                 }
                 else if (local_queue.front().work.size() > param.chunk_size)
                 {
@@ -151,22 +242,130 @@ namespace components
 
                 stealstack_node & node = local_queue.front();
 
-                node.work.push_back(n);
+                node.push_back(n, payload, param.payload_bytes, c);
             }
             local_work++;
+            local_cost += c;
             std::size_t local_work_tmp = local_work;
             stat.max_stack_depth = (std::max)(local_work_tmp, stat.max_stack_depth);
             distribute_work();
         }
 
+        // Memory held by the chunks in local_queue. Must be called with
+        // local_queue_mtx held, the time-weighted average is integrated
+        // between tree_search start and end.
+        void update_queue_byte_time()
+        {
+            boost::uint64_t now = hpx::util::high_resolution_clock::now();
+            if(queue_bytes_since != 0)
+            {
+                queue_byte_ns += static_cast<double>(queue_bytes) * (now - queue_bytes_since);
+                queue_bytes_since = now;
+            }
+        }
+
+        void add_queue_bytes(std::size_t bytes)
+        {
+            update_queue_byte_time();
+            queue_bytes += bytes;
+            std::size_t queue_bytes_tmp = queue_bytes;
+            stat.max_queue_bytes = (std::max)(stat.max_queue_bytes, queue_bytes_tmp);
+        }
+
+        void sub_queue_bytes(std::size_t bytes)
+        {
+            update_queue_byte_time();
+            queue_bytes -= bytes;
+        }
+
+        // Bounded memory mode: while the queue holds more than
+        // queue_memory_cap bytes, the subtree below parent is expanded depth
+        // first on a private stack instead of through the queue. Once
+        // thieves have taken the queue below half of the cap, the rest of
+        // the stack goes back to the queue.
+        void expand_depth_first(node & parent, char const * payload)
+        {
+            std::vector<node> stack;
+            gen_children(parent, payload, &stack);
+
+            std::size_t nodes = 0;
+            while(!stack.empty())
+            {
+                if(queue_bytes < param.queue_memory_cap / 2)
+                {
+                    BOOST_FOREACH(node const & n, stack)
+                    {
+                        put_work(n, payload);
+                    }
+                    break;
+                }
+
+                node n = stack.back();
+                stack.pop_back();
+                ++nodes;
+                gen_children(n, payload, &stack);
+            }
+
+            dfs_nodes += nodes;
+            nodes_done += nodes;
+        }
+
+        void expand(node & parent, char const * payload)
+        {
+            if(param.queue_memory_cap != 0 && queue_bytes > param.queue_memory_cap)
+            {
+                expand_depth_first(parent, payload);
+            }
+            else
+            {
+                gen_children(parent, payload, 0);
+            }
+        }
+
+        // With balance-by-cost the surplus is measured in estimated cost, a
+        // chunk_size * chunk_size node threshold otherwise.
+        bool has_surplus() const
+        {
+            if(param.balance_by_cost)
+            {
+                return local_cost > param.chunk_size * param.chunk_size * param.expected_cost();
+            }
+            return local_work > param.chunk_size * param.chunk_size;
+        }
+
+        // Number of chunks to share from the back of the queue: half of the
+        // chunks, or as many as needed to hand over half of the estimated
+        // cost. Must be called with local_queue_mtx held.
+        std::size_t surplus_chunks() const
+        {
+            if(!param.balance_by_cost)
+            {
+                return local_queue.size()/2;
+            }
+
+            std::size_t half_cost = local_cost/2;
+            std::size_t cost = 0;
+            std::size_t num = 0;
+            std::deque<stealstack_node>::const_reverse_iterator it = local_queue.rbegin();
+            while(num + 1 < local_queue.size() && cost < half_cost)
+            {
+                cost += it->cost;
+                ++it;
+                ++num;
+            }
+            return num;
+        }
+
         void distribute_work()
         {
             if(size == 1) return;
 
-            if(local_work > param.chunk_size * param.chunk_size)
+            if(has_surplus())
             {
                 std::vector<stealstack_node> nodes;
                 std::size_t idx = 0;
+                std::size_t num_nodes = 0;
+                boost::uint64_t begin = trace.enabled ? trace_buffers::now() : 0;
                 {
                     mutex_type::scoped_lock lk(local_queue_mtx);
                     /*
@@ -178,18 +377,25 @@ namespace components
                     }
                     else
                     */
+                    if(param.steal_policy == params::STEAL_LOAD_WEIGHTED)
+                    {
+                        last_share = loads.least_loaded(last_share);
+                        idx = last_share;
+                    }
+                    else
                     {
                         last_share = (last_share + 1) % size;
                         if(last_share == rank) last_share = (last_share + 1) % size;
                         idx = last_share;
                     }
 
-                    std::size_t steal_num = local_queue.size()/2;
+                    std::size_t steal_num = surplus_chunks();
                     nodes.resize(steal_num);
                     for(std::size_t i = 0; i < steal_num; ++i)
                     {
                         std::swap(nodes[i], local_queue.back());
                         local_queue.pop_back();
+                        sub_queue_bytes(nodes[i].bytes());
 
                         if(local_work < nodes[i].work.size())
                         {
@@ -197,15 +403,136 @@ namespace components
                                 "gen_children(): local_work count is less than 0!");
                         }
                         local_work -= nodes[i].work.size();
+                        local_cost -= nodes[i].cost;
                         work_shared += nodes[i].work.size();
+                        num_nodes += nodes[i].work.size();
+                        if(nodes[i].work.size() > 0) ++stat.n_release;
                     }
                 }
-                hpx::apply<share_work_action>(ids[idx], rank, nodes);
+                // assume the work arrives until the acknowledgement tells better
+                loads.add(idx, num_nodes);
+                if(param.share_batch <= 1)
+                {
+                    ++share_msgs;
+                    hpx::apply<share_work_action>(ids[idx], rank,
+                        static_cast<std::size_t>(local_work), std::size_t(0), nodes);
+                }
+                else
+                {
+                    {
+                        mutex_type::scoped_lock lk(outbox_mtx);
+                        outbox & out = outboxes[idx];
+                        out.chunks.insert(out.chunks.end(), nodes.begin(), nodes.end());
+                        out.nodes += num_nodes;
+                        if(out.since == 0) out.since = hpx::util::high_resolution_clock::now();
+                    }
+                    flush_outbox(idx, false);
+                }
+
+                if(trace.enabled)
+                {
+                    trace.record(trace_event::SHARE, begin, trace_buffers::now(),
+                        idx, nodes.size(), num_nodes);
+                }
+            }
+        }
+
+        // Send the batches which are full or older than the batch window, or
+        // all of them if force is set. Pending acknowledgements travel with
+        // the shares to the same destination. Called once per chunk of
+        // parents and when running out of work, not for every node.
+        void flush_outboxes(bool force)
+        {
+            if(param.share_batch <= 1) return;
+
+            for(std::size_t dst = 0; dst < outboxes.size(); ++dst)
+            {
+                flush_outbox(dst, force);
+            }
+        }
+
+        void flush_outbox(std::size_t dst, bool force)
+        {
+            outbox out;
+            {
+                mutex_type::scoped_lock lk(outbox_mtx);
+                outbox & pending = outboxes[dst];
+                if(pending.since == 0) return;
+                if(!force
+                    && pending.chunks.size() < param.share_batch
+                    && pending.ack_msgs < param.share_batch
+                    && hpx::util::high_resolution_clock::now() - pending.since
+                        < static_cast<boost::uint64_t>(param.share_batch_window) * 1000)
+                {
+                    return;
+                }
+                out.chunks.swap(pending.chunks);
+                out.nodes = pending.nodes;
+                out.acks = pending.acks;
+                out.ack_msgs = pending.ack_msgs;
+                pending = outbox();
+            }
+
+            if(!out.chunks.empty())
+            {
+                ++share_msgs;
+                hpx::apply<share_work_action>(ids[dst], rank,
+                    static_cast<std::size_t>(local_work), out.acks, out.chunks);
+            }
+            else
+            {
+                ++ack_msgs;
+                hpx::apply<ack_share_action>(ids[dst], rank, out.acks,
+                    static_cast<std::size_t>(local_work));
+            }
+        }
+
+        // Expand a node of an explicit tree, the children are read from the
+        // CSR instead of being computed
+        void gen_children_csr(node & parent, char const * payload, std::vector<node> * stack)
+        {
+            std::size_t parent_height = parent.height;
+
+            stat.max_tree_depth = (std::max)(stat.max_tree_depth, parent_height);
+
+            boost::uint64_t index = parent.csr_index();
+            int num_children = csr.num_children(index);
+
+            parent.num_children = num_children;
+
+            if(param.reduce)
+            {
+                summary.add(parent, num_children);
+            }
+
+            if(num_children > 0)
+            {
+                for(int i = 0; i < num_children; ++i)
+                {
+                    node child;
+                    child.type = parent.type;
+                    child.height = parent_height + 1;
+                    child.set_csr_index(csr.child(index, i));
+
+                    if(stack) stack->push_back(child);
+                    else put_work(child, payload);
+                }
+            }
+            else
+            {
+                ++stat.n_leaves;
             }
         }
 
-        void gen_children(node & parent)
+        // Put the children of parent into the queue, or on stack if given
+        void gen_children(node & parent, char const * payload, std::vector<node> * stack)
         {
+            if(csr.is_open())
+            {
+                gen_children_csr(parent, payload, stack);
+                return;
+            }
+
             std::size_t parent_height = parent.height;
 
             stat.max_tree_depth = (std::max)(stat.max_tree_depth, parent_height);
@@ -215,20 +542,30 @@ namespace components
 
             parent.num_children = num_children;
 
-            if(num_children > 0)
+            if(param.reduce)
             {
+                summary.add(parent, num_children);
+            }
 
+            if(num_children > 0)
+            {
+                int granularity = parent.cost(param);
+                if(slow)
+                {
+                    granularity = static_cast<int>(std::ceil(granularity * param.slowdown));
+                }
                 for(int i = 0; i < num_children; ++i)
                 {
                     node child;
                     child.type = child_type;
                     child.height = parent_height + 1;
-                    for(int j = 0; j < param.compute_granularity; ++j)
+                    for(int j = 0; j < granularity; ++j)
                     {
                         rng_spawn(parent.state.state, child.state.state, i);
                     }
 
-                    put_work(child);
+                    if(stack) stack->push_back(child);
+                    else put_work(child, payload);
                 }
             }
             else
@@ -237,9 +574,15 @@ namespace components
             }
         }
 
-        void share_work(std::size_t src, std::vector<stealstack_node> const & work)
+        void share_work(std::size_t src, std::size_t src_load, std::size_t acked,
+            std::vector<stealstack_node> const & work)
         {
+            loads.update(src, src_load);
+            work_shared -= acked;
+
+            boost::uint64_t begin = trace.enabled ? trace_buffers::now() : 0;
             std::size_t count = 0;
+            std::size_t chunks = 0;
             BOOST_FOREACH(stealstack_node const & ss_node, work)
             {
                 if(ss_node.work.size() > 0)
@@ -247,20 +590,47 @@ namespace components
                     mutex_type::scoped_lock lk(local_queue_mtx);
 
                     local_queue.push_back(ss_node);
+                    add_queue_bytes(local_queue.back().bytes());
                     local_work += ss_node.work.size();
+                    local_cost += ss_node.cost;
                     count += ss_node.work.size();
+                    ++chunks;
+                    ++stat.n_steal;
                 }
             }
-            hpx::apply<ack_share_action>(ids[src], count);
+            if(param.share_batch <= 1)
+            {
+                ++ack_msgs;
+                hpx::apply<ack_share_action>(ids[src], rank, count,
+                    static_cast<std::size_t>(local_work));
+            }
+            else
+            {
+                {
+                    mutex_type::scoped_lock lk(outbox_mtx);
+                    outbox & out = outboxes[src];
+                    out.acks += count;
+                    ++out.ack_msgs;
+                    if(out.since == 0) out.since = hpx::util::high_resolution_clock::now();
+                }
+                flush_outbox(src, false);
+            }
+
+            if(trace.enabled)
+            {
+                trace.record(trace_event::TRANSFER, begin, trace_buffers::now(),
+                    src, chunks, count);
+            }
             
             distribute_work();
         }
         
         HPX_DEFINE_COMPONENT_ACTION(wm_stealstack, share_work);
 
-        void ack_share(std::size_t work)
+        void ack_share(std::size_t dst, std::size_t work, std::size_t dst_load)
         {
             work_shared -= work;
+            loads.update(dst, dst_load);
         }
         
         HPX_DEFINE_COMPONENT_ACTION(wm_stealstack, ack_share);
@@ -292,8 +662,23 @@ namespace components
 
         bool ensure_local_work()
         {
+            boost::uint64_t idle_begin = 0;
+            if(trace.enabled && local_work == 0)
+            {
+                idle_begin = trace_buffers::now();
+            }
+
+            if(local_work == 0)
+            {
+                active = false;
+            }
+
             while(local_work == 0)
             {
+                // nothing left to batch with, the peers wait for the shares
+                // and acknowledgements to decide about termination
+                flush_outboxes(true);
+
                 std::vector<hpx::future<bool> > terminate_futures;
 
                 if(rank > 0)
@@ -340,13 +725,28 @@ namespace components
                     terminate_futures.erase(terminate_futures.begin() + pos);
                 }
 
-                if(terminate) return false;
+                if(terminate)
+                {
+                    if(trace.enabled)
+                    {
+                        trace.record(trace_event::IDLE, idle_begin,
+                            trace_buffers::now(), rank);
+                    }
+                    return false;
+                }
+            }
+
+            if(trace.enabled && idle_begin != 0)
+            {
+                trace.record(trace_event::IDLE, idle_begin,
+                    trace_buffers::now(), rank);
             }
 
+            active = true;
             return true;
         }
 
-        bool get_work(std::vector<node> & work)
+        bool get_work(stealstack_node & work)
         {
             if(!ensure_local_work())
             {
@@ -355,19 +755,21 @@ namespace components
 
             {
                 mutex_type::scoped_lock lk(local_queue_mtx);
-                std::swap(work, local_queue.front().work);
+                work.swap(local_queue.front());
                 local_queue.pop_front();
+                sub_queue_bytes(work.bytes());
             }
 
-            stat.n_nodes += work.size();
-            if (local_work < work.size())
+            nodes_done += work.work.size();
+            if (local_work < work.work.size())
             {
                 throw std::logic_error(
                     "ensure_local_work(): local_work count is less than 0!");
             }
-            local_work -= work.size();
+            local_work -= work.work.size();
+            local_cost -= work.cost;
 
-            if(work.size() == 0)
+            if(work.work.size() == 0)
             {
                 hpx::cout << "get_work(): called with work.size() = 0, "
                     << "local_work=" << local_work
@@ -382,27 +784,64 @@ namespace components
 
         void tree_search()
         {
-            std::vector<node> parents;
+            hpx::util::high_resolution_timer t;
+            boost::uint64_t search_begin = hpx::util::high_resolution_clock::now();
+            {
+                mutex_type::scoped_lock lk(local_queue_mtx);
+                queue_byte_ns = 0.0;
+                queue_bytes_since = search_begin;
+            }
+            stealstack_node parents;
             /*
             std::vector<hpx::future<void> > gen_children_futures;
             gen_children_futures.reserve(param.chunk_size);
             */
             while(get_work(parents))
             {
-                BOOST_FOREACH(node & parent, parents)
+                bool expanded = !parents.work.empty();
+                for(std::size_t i = 0; i < parents.work.size(); ++i)
                 {
                     /*
                     gen_children_futures.push_back(
                         hpx::async(&wm_stealstack::gen_children, this, parent)
                     );
                     */
-                    gen_children(parent);
+                    expand(parents.work[i], parents.get_payload(i, param.payload_bytes));
                 }
                 parents.clear();
                 /*
                 hpx::wait(gen_children_futures);
                 gen_children_futures.clear();
                 */
+
+                // send the batches whose window expired while expanding
+                flush_outboxes(false);
+
+                if(slow && param.slow_sleep > 0)
+                {
+                    hpx::this_thread::suspend(
+                        boost::posix_time::microseconds(param.slow_sleep));
+                }
+
+                // every stealstack stays in the loop until global
+                // termination, the end of its last useful work tells the
+                // stragglers apart
+                if(expanded)
+                {
+                    stat.completion_time = t.elapsed();
+                }
+            }
+            active = false;
+
+            {
+                mutex_type::scoped_lock lk(local_queue_mtx);
+                update_queue_byte_time();
+                boost::uint64_t search_end = queue_bytes_since;
+                queue_bytes_since = 0;
+                if(search_end > search_begin)
+                {
+                    stat.avg_queue_bytes = queue_byte_ns / (search_end - search_begin);
+                }
             }
         }
 
@@ -410,18 +849,62 @@ namespace components
 
         stats get_stats()
         {
+            // these counters are updated by concurrent tasks
+            stat.n_nodes = nodes_done;
+            stat.n_dfs_nodes = dfs_nodes;
+            stat.n_share_msgs = share_msgs;
+            stat.n_ack_msgs = ack_msgs;
             return stat;
         }
 
         HPX_DEFINE_COMPONENT_ACTION(wm_stealstack, get_stats);
 
+        trace_data get_trace()
+        {
+            return trace.get();
+        }
+
+        HPX_DEFINE_COMPONENT_ACTION(wm_stealstack, get_trace);
+
+        progress get_progress()
+        {
+            progress p;
+            p.nodes = nodes_done;
+            p.active = active;
+            return p;
+        }
+
+        HPX_DEFINE_COMPONENT_ACTION(wm_stealstack, get_progress);
+
+        tree_summary get_summary()
+        {
+            return summary.combine();
+        }
+
+        HPX_DEFINE_COMPONENT_ACTION(wm_stealstack, get_summary);
+
     private:
         std::vector<hpx::id_type> ids;
         boost::atomic<std::size_t> local_work;
+        boost::atomic<std::size_t> local_cost;
+        boost::atomic<std::size_t> nodes_done;  // read by get_progress
+        boost::atomic<std::size_t> dfs_nodes;   // nodes expanded depth first
+        boost::atomic<std::size_t> share_msgs;  // sent from concurrent tasks
+        boost::atomic<std::size_t> ack_msgs;
+        boost::atomic<bool> active;
+        boost::atomic<std::size_t> queue_bytes;     // modified with local_queue_mtx held
+        double queue_byte_ns;
+        boost::uint64_t queue_bytes_since;
         boost::atomic<std::size_t> work_shared;
         std::set<std::size_t> need_work;
 
         stats stat;
+        trace_buffers trace;
+        load_table loads;
+        csr_tree csr;
+        combinable_summary summary;
+        std::vector<outbox> outboxes;
+        mutex_type outbox_mtx;
 
         double walltime;
         double work_time;
@@ -444,6 +927,7 @@ namespace components
 
         params param;
         bool pollint_adaptive;
+        bool slow;
         std::size_t rank;
         std::size_t size;
     };
@@ -7,10 +7,17 @@
 #ifndef BENCHMARKS_UTS_WS_STEALSTACK_HPP
 #define BENCHMARKS_UTS_WS_STEALSTACK_HPP
 
+#include <benchmarks/uts/csr.hpp>
+#include <benchmarks/uts/load_table.hpp>
 #include <benchmarks/uts/params.hpp>
+#include <benchmarks/uts/reduction.hpp>
+#include <benchmarks/uts/schedule.hpp>
+#include <benchmarks/uts/timeline.hpp>
+#include <benchmarks/uts/trace.hpp>
 #include <hpx/include/async.hpp>
 #include <hpx/include/components.hpp>
 #include <hpx/lcos/local/condition_variable.hpp>
+#include <hpx/util/high_resolution_timer.hpp>
 
 #include <boost/ref.hpp>
 
@@ -39,6 +46,13 @@ namespace components
               , n_fail(0)
               , max_stack_depth(0)
               , max_tree_depth(0)
+              , completion_time(0.0)
+              , slow(false)
+              , max_queue_bytes(0)
+              , avg_queue_bytes(0.0)
+              , n_dfs_nodes(0)
+              , n_replayed(0)
+              , n_diverged(0)
             {
                 time[WORK] = 0.0;
                 time[SEARCH] = 0.0;
@@ -60,6 +74,16 @@ namespace components
                 ar & max_tree_depth;
 
                 ar & time;
+
+                ar & completion_time;
+                ar & slow;
+
+                ar & max_queue_bytes;
+                ar & avg_queue_bytes;
+                ar & n_dfs_nodes;
+
+                ar & n_replayed;
+                ar & n_diverged;
             }
 
             std::size_t n_nodes;
@@ -73,10 +97,47 @@ namespace components
             std::size_t max_tree_depth;
 
             double time[NSTATES];
+
+            double completion_time;     // seconds until the last chunk was expanded
+            bool slow;                  // slowed down by --slow-ranks
+
+            std::size_t max_queue_bytes;    // peak memory held by local_queue
+            double avg_queue_bytes;         // time-weighted average over tree_search
+            std::size_t n_dfs_nodes;        // nodes expanded in bounded memory mode
+
+            std::size_t n_replayed;     // steal attempts taken from a recorded schedule
+            std::size_t n_diverged;     // replayed steal attempts with a different outcome
+        };
+
+        struct steal_reply
+        {
+            steal_reply()
+              : has_work(false)
+              , load(0)
+            {}
+
+            template <typename Archive>
+            void serialize(Archive & ar, unsigned)
+            {
+                ar & has_work;
+                ar & load;
+                ar & chunks;
+            }
+
+            bool has_work;      // the victim still has work, maybe too little to share
+            std::size_t load;   // local_work of the victim after the steal
+            std::vector<stealstack_node> chunks;
         };
 
         ws_stealstack()
           : local_work(0)
+          , local_cost(0)
+          , nodes_done(0)
+          , dfs_nodes(0)
+          , active(false)
+          , queue_bytes(0)
+          , queue_byte_ns(0.0)
+          , queue_bytes_since(0)
           , work_shared(0)
           , walltime(0)
           , work_time(0)
@@ -91,6 +152,8 @@ namespace components
           , ctrl_recvd(0)
           , ctrl_sent(0)
           , pollint_adaptive(false)
+          , slow(false)
+          , node_limit(0)
         {
         }
 
@@ -103,20 +166,48 @@ namespace components
             size = s;
             param = p;
 
+            slow = p.is_slow(rank);
+            stat.slow = slow;
+
             last_steal = rank;
             last_share = rank;
 
+            loads.init(rank, size);
+
+            // every stealstack explores its share of a truncated search
+            node_limit = p.max_nodes == 0 ? 0 : (p.max_nodes + size - 1) / size;
+
+            if(p.debug & UTS_DEBUG_TRACE)
+            {
+                trace.init(rank, hpx::get_os_thread_count(), p.trace_buffer_size);
+            }
+
             if(p.polling_interval == 0)
             {
                 pollint_adaptive = true;
                 p.polling_interval = 1;
             }
 
+            if(p.reduce)
+            {
+                summary.init(hpx::get_os_thread_count());
+            }
+
+            if(!p.csr_file.empty())
+            {
+                csr.open(p.csr_file);
+            }
+
             if(rank == 0)
             {
                 node n;
                 n.init_root(param);
-                put_work(n);
+                if(csr.is_open())
+                {
+                    n.set_csr_index(csr.root());
+                }
+                std::vector<char> payload(param.payload_bytes, 'a');
+                put_work(n, payload.empty() ? 0 : &payload[0]);
             }
         }
 
@@ -129,23 +220,26 @@ namespace components
 
         HPX_DEFINE_COMPONENT_ACTION(ws_stealstack, resolve_names);
 
-        void put_work(node const & n)
+        void put_work(node const & n, char const * payload)
         {
+            std::size_t c = param.balance_by_cost ? n.cost(param) : 0;
             {
                 mutex_type::scoped_lock lk(local_queue_mtx);
                 /* If the stack is empty, push an empty stealstack_node. */
                 if(local_queue.empty())
                 {
-                    stealstack_node node(param.chunk_size);
+                    stealstack_node node(param.chunk_size, param.payload_bytes);
                     local_queue.push_front(node);
+                    add_queue_bytes(local_queue.front().bytes());
                 }
 
 
                 /* If the current stealstack_node is full, push a new one. */
                 if(local_queue.front().work.size() == param.chunk_size)
                 {
-                    stealstack_node node(param.chunk_size);
+                    stealstack_node node(param.chunk_size, param.payload_bytes);
                     local_queue.push_front(node);
+                    add_queue_bytes(local_queue.front().bytes());
                 }
                 else if (local_queue.front().work.size() > param.chunk_size)
                 {
@@ -154,15 +248,60 @@ namespace components
 
                 stealstack_node & node = local_queue.front();
 
-                node.work.push_back(n);
+                node.push_back(n, payload, param.payload_bytes, c);
             }
             local_work++;
+            local_cost += c;
             std::size_t local_work_tmp = local_work;
             stat.max_stack_depth = (std::max)(local_work_tmp, stat.max_stack_depth);
         }
 
-        void gen_children(node & parent)
+        // Expand a node of an explicit tree, the children are read from the
+        // CSR instead of being computed
+        void gen_children_csr(node & parent, char const * payload, std::vector<node> * stack)
+        {
+            std::size_t parent_height = parent.height;
+
+            stat.max_tree_depth = (std::max)(stat.max_tree_depth, parent_height);
+
+            boost::uint64_t index = parent.csr_index();
+            int num_children = csr.num_children(index);
+
+            parent.num_children = num_children;
+
+            if(param.reduce)
+            {
+                summary.add(parent, num_children);
+            }
+
+            if(num_children > 0)
+            {
+                for(int i = 0; i < num_children; ++i)
+                {
+                    node child;
+                    child.type = parent.type;
+                    child.height = parent_height + 1;
+                    child.set_csr_index(csr.child(index, i));
+
+                    if(stack) stack->push_back(child);
+                    else put_work(child, payload);
+                }
+            }
+            else
+            {
+                ++stat.n_leaves;
+            }
+        }
+
+        // Put the children of parent into the queue, or on stack if given
+        void gen_children(node & parent, char const * payload, std::vector<node> * stack)
         {
+            if(csr.is_open())
+            {
+                gen_children_csr(parent, payload, stack);
+                return;
+            }
+
             std::size_t parent_height = parent.height;
 
             stat.max_tree_depth = (std::max)(stat.max_tree_depth, parent_height);
@@ -172,20 +311,30 @@ namespace components
 
             parent.num_children = num_children;
 
-            if(num_children > 0)
+            if(param.reduce)
             {
+                summary.add(parent, num_children);
+            }
 
+            if(num_children > 0)
+            {
+                int granularity = parent.cost(param);
+                if(slow)
+                {
+                    granularity = static_cast<int>(std::ceil(granularity * param.slowdown));
+                }
                 for(int i = 0; i < num_children; ++i)
                 {
                     node child;
                     child.type = child_type;
                     child.height = parent_height + 1;
-                    for(int j = 0; j < param.compute_granularity; ++j)
+                    for(int j = 0; j < granularity; ++j)
                     {
                         rng_spawn(parent.state.state, child.state.state, i);
                     }
 
-                    put_work(child);
+                    if(stack) stack->push_back(child);
+                    else put_work(child, payload);
                 }
             }
             else
@@ -194,34 +343,165 @@ namespace components
             }
         }
 
-        std::pair<bool, std::vector<stealstack_node> > steal_work()
+        // Memory held by the chunks in local_queue. Must be called with
+        // local_queue_mtx held, the time-weighted average is integrated
+        // between tree_search start and end.
+        void update_queue_byte_time()
+        {
+            boost::uint64_t now = hpx::util::high_resolution_clock::now();
+            if(queue_bytes_since != 0)
+            {
+                queue_byte_ns += static_cast<double>(queue_bytes) * (now - queue_bytes_since);
+                queue_bytes_since = now;
+            }
+        }
+
+        void add_queue_bytes(std::size_t bytes)
+        {
+            update_queue_byte_time();
+            queue_bytes += bytes;
+            std::size_t queue_bytes_tmp = queue_bytes;
+            stat.max_queue_bytes = (std::max)(stat.max_queue_bytes, queue_bytes_tmp);
+        }
+
+        void sub_queue_bytes(std::size_t bytes)
+        {
+            update_queue_byte_time();
+            queue_bytes -= bytes;
+        }
+
+        // Bounded memory mode: while the queue holds more than
+        // queue_memory_cap bytes, the subtree below parent is expanded depth
+        // first on a private stack instead of through the queue. Once
+        // thieves have taken the queue below half of the cap, the rest of
+        // the stack goes back to the queue.
+        void expand_depth_first(node & parent, char const * payload)
         {
-            std::pair<bool, std::vector<stealstack_node> > res = 
-                std::make_pair(false, std::vector<stealstack_node>());
+            std::vector<node> stack;
+            gen_children(parent, payload, &stack);
 
-            if(local_work > param.chunk_size * param.chunk_size)
+            std::size_t nodes = 0;
+            while(!stack.empty())
             {
-                mutex_type::scoped_lock lk(local_queue_mtx);
-                std::size_t steal_num = local_queue.size()/2;
-                res.second.resize(steal_num);
-                for(std::size_t i = 0; i < steal_num; ++i)
+                if(queue_bytes < param.queue_memory_cap / 2)
                 {
-                    std::swap(res.second[i], local_queue.back());
-                    local_queue.pop_back();
+                    BOOST_FOREACH(node const & n, stack)
+                    {
+                        put_work(n, payload);
+                    }
+                    break;
+                }
+
+                node n = stack.back();
+                stack.pop_back();
+                ++nodes;
+                gen_children(n, payload, &stack);
+            }
+
+            dfs_nodes += nodes;
+            nodes_done += nodes;
+        }
+
+        void expand(node & parent, char const * payload)
+        {
+            if(param.queue_memory_cap != 0 && queue_bytes > param.queue_memory_cap)
+            {
+                expand_depth_first(parent, payload);
+            }
+            else
+            {
+                gen_children(parent, payload, 0);
+            }
+        }
+
+        // With balance-by-cost the surplus is measured in estimated cost, a
+        // chunk_size * chunk_size node threshold otherwise.
+        bool has_surplus() const
+        {
+            if(param.balance_by_cost)
+            {
+                return local_cost > param.chunk_size * param.chunk_size * param.expected_cost();
+            }
+            return local_work > param.chunk_size * param.chunk_size;
+        }
+
+        // Number of chunks to give away from the back of the queue: half of
+        // the chunks, or as many as needed to hand over half of the estimated
+        // cost. Must be called with local_queue_mtx held.
+        std::size_t surplus_chunks() const
+        {
+            if(!param.balance_by_cost)
+            {
+                return local_queue.size()/2;
+            }
 
-                    if(local_work < res.second[i].work.size())
+            std::size_t half_cost = local_cost/2;
+            std::size_t cost = 0;
+            std::size_t num = 0;
+            std::deque<stealstack_node>::const_reverse_iterator it = local_queue.rbegin();
+            while(num + 1 < local_queue.size() && cost < half_cost)
+            {
+                cost += it->cost;
+                ++it;
+                ++num;
+            }
+            return num;
+        }
+
+        // want is the number of chunks asked for by a thief replaying a
+        // steal schedule, steal_any otherwise. A replayed steal never takes
+        // the last chunk of the queue.
+        static const std::size_t steal_any = std::size_t(-1);
+
+        steal_reply steal_work(std::size_t thief, std::size_t want)
+        {
+            steal_reply res;
+
+            // the thief is out of work
+            loads.update(thief, 0);
+
+            if(want == steal_any ? has_surplus() : want > 0)
+            {
+                boost::uint64_t begin = trace.enabled ? trace_buffers::now() : 0;
+                std::size_t nodes = 0;
+                {
+                    mutex_type::scoped_lock lk(local_queue_mtx);
+                    std::size_t steal_num = surplus_chunks();
+                    if(want != steal_any)
                     {
-                        throw std::logic_error(
-                            "ensure_local_work(): local_work count is less than 0!");
+                        steal_num = local_queue.empty() ? 0
+                            : (std::min)(want, local_queue.size() - 1);
                     }
-                    local_work -= res.second[i].work.size();
+                    res.chunks.resize(steal_num);
+                    for(std::size_t i = 0; i < steal_num; ++i)
+                    {
+                        std::swap(res.chunks[i], local_queue.back());
+                        local_queue.pop_back();
+                        sub_queue_bytes(res.chunks[i].bytes());
+
+                        if(local_work < res.chunks[i].work.size())
+                        {
+                            throw std::logic_error(
+                                "ensure_local_work(): local_work count is less than 0!");
+                        }
+                        local_work -= res.chunks[i].work.size();
+                        local_cost -= res.chunks[i].cost;
+                        nodes += res.chunks[i].work.size();
+                        if(res.chunks[i].work.size() > 0) ++stat.n_release;
+                    }
+                }
+                if(trace.enabled)
+                {
+                    trace.record(trace_event::SHARE, begin, trace_buffers::now(),
+                        thief, res.chunks.size(), nodes);
                 }
             }
 
             if(local_work > 0 || work_shared > 0)
             {
-                res.first = true;
+                res.has_work = true;
             }
+            res.load = local_work;
 
             return res;
         }
@@ -230,46 +510,150 @@ namespace components
 
         bool ensure_local_work()
         {
+            boost::uint64_t idle_begin = 0;
+            if(trace.enabled && local_work == 0)
+            {
+                idle_begin = trace_buffers::now();
+            }
+
+            if(local_work == 0)
+            {
+                active = false;
+            }
+
             while(local_work == 0)
             {
+                // replayed attempts follow the recorded victims, which need
+                // not cover every peer, only a sweep of the steal policy
+                // may end the search
                 bool terminate = true;
+                bool replayed = false;
+                std::vector<std::size_t> victims;
+                if(param.steal_policy == params::STEAL_LOAD_WEIGHTED)
+                {
+                    victims = loads.victim_order();
+                }
                 for(std::size_t i = 0; i < size -1; ++i)
                 {
-                    last_steal = (last_steal + 1) % size;
-                    if(last_steal == rank) last_steal = (last_steal + 1) % size;
+                    std::size_t want = steal_any;
+                    if(schedule.replaying())
+                    {
+                        last_steal = steal_schedule::victim(schedule.peek());
+                        want = steal_schedule::chunks(schedule.peek());
+                        if(last_steal >= size || last_steal == rank)
+                        {
+                            throw std::logic_error(
+                                "ensure_local_work(): invalid victim in steal schedule");
+                        }
+                        replayed = true;
+                    }
+                    else if(param.steal_policy == params::STEAL_LOAD_WEIGHTED)
+                    {
+                        last_steal = victims[i];
+                    }
+                    else
+                    {
+                        last_steal = (last_steal + 1) % size;
+                        if(last_steal == rank) last_steal = (last_steal + 1) % size;
+                    }
+
+                    boost::uint64_t steal_begin = trace.enabled ? trace_buffers::now() : 0;
 
                     ws_stealstack::steal_work_action act;
-                    std::pair<bool, std::vector<stealstack_node> > node_pair(boost::move(act(ids[last_steal])));
+                    steal_reply reply(boost::move(act(ids[last_steal], rank, want)));
+                    loads.update(last_steal, reply.load);
+
+                    boost::uint64_t steal_end = trace.enabled ? trace_buffers::now() : 0;
+                    std::size_t chunks = 0;
+                    std::size_t nodes = 0;
 
                     bool break_ = false;
-                    BOOST_FOREACH(stealstack_node & ss_node, node_pair.second)
+                    BOOST_FOREACH(stealstack_node & ss_node, reply.chunks)
                     {
                         if(ss_node.work.size() > 0)
                         {
                             mutex_type::scoped_lock lk(local_queue_mtx);
                             terminate = false;
 
+                            ++chunks;
+                            nodes += ss_node.work.size();
                             local_queue.push_back(ss_node);
+                            add_queue_bytes(local_queue.back().bytes());
                             local_work += ss_node.work.size();
+                            local_cost += ss_node.cost;
                             break_ = true;
                         }
                     }
+
+                    trace_event::outcome_type outcome
+                        = chunks > 0 ? trace_event::SUCCESS
+                        : reply.has_work ? trace_event::VICTIM_BUSY
+                        : trace_event::VICTIM_IDLE;
+                    schedule.add(last_steal, chunks, outcome);
+
+                    if(trace.enabled)
+                    {
+                        trace.record(trace_event::STEAL, steal_begin, steal_end,
+                            last_steal, chunks, nodes, outcome);
+                        if(chunks > 0)
+                        {
+                            trace.record(trace_event::TRANSFER, steal_end,
+                                trace_buffers::now(), last_steal, chunks, nodes);
+                        }
+                    }
+
+                    stat.n_steal += chunks;
+                    if(chunks == 0) ++stat.n_fail;
+
                     if(break_ || local_work > 0) break;
 
-                    if(node_pair.first)
+                    if(reply.has_work)
                     {
                         terminate = false;
                     }
                 }
 
-                if(terminate) return false;
+                if(terminate && !replayed)
+                {
+                    if(trace.enabled)
+                    {
+                        trace.record(trace_event::IDLE, idle_begin,
+                            trace_buffers::now(), rank);
+                    }
+                    return false;
+                }
+            }
+
+            if(trace.enabled && idle_begin != 0)
+            {
+                trace.record(trace_event::IDLE, idle_begin,
+                    trace_buffers::now(), rank);
             }
 
+            active = true;
             return true;
         }
 
-        bool get_work(std::vector<node> & work)
+        // Drop the remaining work once the share of a truncated search is
+        // explored. Thieves find nothing to steal here anymore, so the
+        // search terminates as usual.
+        void truncate()
         {
+            mutex_type::scoped_lock lk(local_queue_mtx);
+            local_queue.clear();
+            sub_queue_bytes(queue_bytes);
+            local_work = 0;
+            local_cost = 0;
+        }
+
+        bool get_work(stealstack_node & work)
+        {
+            if(node_limit != 0 && nodes_done >= node_limit)
+            {
+                truncate();
+                return false;
+            }
+
             if(!ensure_local_work())
             {
                 return false;
@@ -277,19 +661,21 @@ namespace components
 
             {
                 mutex_type::scoped_lock lk(local_queue_mtx);
-                std::swap(work, local_queue.front().work);
+                work.swap(local_queue.front());
                 local_queue.pop_front();
+                sub_queue_bytes(work.bytes());
             }
 
-            stat.n_nodes += work.size();
-            if (local_work < work.size())
+            nodes_done += work.work.size();
+            if (local_work < work.work.size())
             {
                 throw std::logic_error(
                     "ensure_local_work(): local_work count is less than 0!");
             }
-            local_work -= work.size();
+            local_work -= work.work.size();
+            local_cost -= work.cost;
 
-            if(work.size() == 0)
+            if(work.work.size() == 0)
             {
                 hpx::cout << "get_work(): called with work.size() = 0, "
                     << "local_work=" << local_work
@@ -303,25 +689,63 @@ namespace components
 
         void tree_search()
         {
-            std::vector<node> parents;
+            hpx::util::high_resolution_timer t;
+            boost::uint64_t search_begin = hpx::util::high_resolution_clock::now();
+            {
+                mutex_type::scoped_lock lk(local_queue_mtx);
+                queue_byte_ns = 0.0;
+                queue_bytes_since = search_begin;
+            }
+            stealstack_node parents;
             std::vector<hpx::future<void> > gen_children_futures;
             gen_children_futures.reserve(param.chunk_size);
             while(get_work(parents))
             {
-                BOOST_FOREACH(node & parent, parents)
+                bool expanded = !parents.work.empty();
+                for(std::size_t i = 0; i < parents.work.size(); ++i)
                 {
                     gen_children_futures.push_back(
-                        hpx::async(&ws_stealstack::gen_children, this, 
-							boost::ref(parent))
+                        hpx::async(&ws_stealstack::expand, this, 
+							boost::ref(parents.work[i]),
+                            parents.get_payload(i, param.payload_bytes))
                     );
                     /*
-                    gen_children(parent);
+                    expand(parents.work[i], parents.get_payload(i, param.payload_bytes));
                     */
                 }
-                parents.clear();
                 //hpx::wait(gen_children_futures);
                 hpx::wait_all(gen_children_futures);
                 gen_children_futures.clear();
+                parents.clear();
+
+                if(slow && param.slow_sleep > 0)
+                {
+                    hpx::this_thread::suspend(
+                        boost::posix_time::microseconds(param.slow_sleep));
+                }
+
+                // every stealstack stays in the loop until global
+                // termination, the end of its last useful work tells the
+                // stragglers apart
+                if(expanded)
+                {
+                    stat.completion_time = t.elapsed();
+                }
+            }
+            active = false;
+
+            stat.n_replayed = schedule.next;
+            stat.n_diverged = schedule.diverged;
+
+            {
+                mutex_type::scoped_lock lk(local_queue_mtx);
+                update_queue_byte_time();
+                boost::uint64_t search_end = queue_bytes_since;
+                queue_bytes_since = 0;
+                if(search_end > search_begin)
+                {
+                    stat.avg_queue_bytes = queue_byte_ns / (search_end - search_begin);
+                }
             }
         }
 
@@ -329,17 +753,78 @@ namespace components
 
         stats get_stats()
         {
+            // the node counts are updated by concurrent expansions
+            stat.n_nodes = nodes_done;
+            stat.n_dfs_nodes = dfs_nodes;
             return stat;
         }
 
         HPX_DEFINE_COMPONENT_ACTION(ws_stealstack, get_stats);
 
+        trace_data get_trace()
+        {
+            return trace.get();
+        }
+
+        HPX_DEFINE_COMPONENT_ACTION(ws_stealstack, get_trace);
+
+        progress get_progress()
+        {
+            progress p;
+            p.nodes = nodes_done;
+            p.active = active;
+            return p;
+        }
+
+        HPX_DEFINE_COMPONENT_ACTION(ws_stealstack, get_progress);
+
+        tree_summary get_summary()
+        {
+            return summary.combine();
+        }
+
+        HPX_DEFINE_COMPONENT_ACTION(ws_stealstack, get_summary);
+
+        // Must be called between init and tree_search
+        void record_schedule()
+        {
+            schedule.record();
+        }
+
+        HPX_DEFINE_COMPONENT_ACTION(ws_stealstack, record_schedule);
+
+        void replay_schedule(std::vector<boost::uint64_t> const & steals)
+        {
+            schedule.replay(steals);
+        }
+
+        HPX_DEFINE_COMPONENT_ACTION(ws_stealstack, replay_schedule);
+
+        std::vector<boost::uint64_t> get_schedule()
+        {
+            return schedule.steals;
+        }
+
+        HPX_DEFINE_COMPONENT_ACTION(ws_stealstack, get_schedule);
+
     private:
         std::vector<hpx::id_type> ids;
         boost::atomic<std::size_t> local_work;
+        boost::atomic<std::size_t> local_cost;
+        boost::atomic<std::size_t> nodes_done;  // read by get_progress
+        boost::atomic<std::size_t> dfs_nodes;   // nodes expanded depth first
+        boost::atomic<bool> active;
+        boost::atomic<std::size_t> queue_bytes;     // modified with local_queue_mtx held
+        double queue_byte_ns;
+        boost::uint64_t queue_bytes_since;
         boost::atomic<std::size_t> work_shared;
 
         stats stat;
+        trace_buffers trace;
+        load_table loads;
+        csr_tree csr;
+        combinable_summary summary;
+        steal_schedule schedule;    // only used by the thread running tree_search
 
         double walltime;
         double work_time;
@@ -362,6 +847,8 @@ namespace components
 
         params param;
         bool pollint_adaptive;
+        bool slow;
+        std::size_t node_limit;
         std::size_t rank;
         std::size_t size;
     };